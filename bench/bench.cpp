@@ -0,0 +1,386 @@
+// microbenchmarks of the engine's primitives (make bench)
+//
+// every benchmark runs over the same fixed positions. a sample repeats the benchmark enough times to take
+// at least SAMPLE_MIN_TIME, after some warmup samples. results are ns per op: median, p99 and mean of the samples.
+// medians can be saved to a baseline file, and later runs compared to it (regressions make the exit code 1)
+//
+// usage: bench [--samples n] [--warmup n] [--filter substr] [--baseline file] [--save file] [--threshold percent]
+
+#include "chessmove.hpp"
+#include "engine.hpp"
+#include "evaluate.hpp"
+#include "movegen.hpp"
+#include "position.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+// openings, middlegames and endgames (mostly the perft test positions)
+static const std::vector<std::string> CORPUS = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 3 9",
+    "2r3k1/5pp1/p3p2p/1p1nP3/3P4/P4N1P/1P3PP1/2R3K1 b - - 1 28",
+    "6k1/5p2/6p1/8/7p/8/6PP/6K1 b - - 0 1",
+    "8/8/4k3/8/2KQ4/8/8/8 w - - 0 1",
+};
+
+// keep the compiler from optimizing away a result
+template <typename T> static void do_not_optimize(const T& value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+static constexpr auto SAMPLE_MIN_TIME = std::chrono::milliseconds(2);
+
+struct benchmark
+{
+    std::string name;
+
+    // one pass over the corpus. returns the number of ops done
+    std::function<uint64_t()> run;
+};
+
+struct result
+{
+    std::string name;
+    uint64_t    ops_per_sample;
+    double      median; // ns/op
+    double      p99;
+    double      mean;
+};
+
+static std::vector<benchmark> make_benchmarks(std::vector<Position>& positions)
+{
+    std::vector<benchmark> benchmarks;
+
+    // same moves every run, generated once
+    std::vector<move_list> pseudo_legal;
+    std::vector<move_list> legal;
+
+    for (Position& pos : positions)
+    {
+        pseudo_legal.push_back(pos.pseudo_legal_moves());
+        legal.push_back(pos.legal_moves());
+    }
+
+    benchmarks.push_back({"bb_rook_moves", [&positions] {
+                              uint64_t ops = 0;
+                              for (const Position& pos : positions)
+                                  for (square sq = 0; sq < 64; sq++, ops++)
+                                      do_not_optimize(bb_rook_moves(sq, pos.pieces()));
+                              return ops;
+                          }});
+
+    benchmarks.push_back({"bb_bishop_moves", [&positions] {
+                              uint64_t ops = 0;
+                              for (const Position& pos : positions)
+                                  for (square sq = 0; sq < 64; sq++, ops++)
+                                      do_not_optimize(bb_bishop_moves(sq, pos.pieces()));
+                              return ops;
+                          }});
+
+    benchmarks.push_back({"sq_attacked", [&positions] {
+                              uint64_t ops = 0;
+                              for (const Position& pos : positions)
+                                  for (square sq = 0; sq < 64; sq++, ops += 2)
+                                  {
+                                      do_not_optimize(pos.sq_attacked(sq, WHITE));
+                                      do_not_optimize(pos.sq_attacked(sq, BLACK));
+                                  }
+                              return ops;
+                          }});
+
+    benchmarks.push_back({"pseudo_legal_moves", [&positions] {
+                              uint64_t ops = 0;
+                              for (const Position& pos : positions)
+                              {
+                                  do_not_optimize(pos.pseudo_legal_moves());
+                                  ops++;
+                              }
+                              return ops;
+                          }});
+
+    benchmarks.push_back({"make_unmake", [&positions, legal] {
+                              uint64_t ops = 0;
+                              for (size_t i = 0; i < positions.size(); i++)
+                                  for (const ChessMove& move : legal[i])
+                                  {
+                                      positions[i].make_move(move);
+                                      positions[i].unmake_last();
+                                      ops++;
+                                  }
+                              return ops;
+                          }});
+
+    // order_moves sorts in place: a copy is sorted every time (into the same list, so nothing is allocated)
+    benchmarks.push_back({"order_moves", [pseudo_legal, scratch = move_list{}]() mutable {
+                              uint64_t ops = 0;
+                              for (const move_list& moves : pseudo_legal)
+                              {
+                                  scratch.assign(moves.begin(), moves.end());
+                                  order_moves(scratch);
+                                  do_not_optimize(scratch.front());
+                                  ops++;
+                              }
+                              return ops;
+                          }});
+
+    // Engine::evaluate is mostly eval cache hits here, the same positions are evaluated over and over
+    benchmarks.push_back({"evaluate", [&positions] {
+                              uint64_t ops = 0;
+                              for (Position& pos : positions)
+                              {
+                                  do_not_optimize(Engine::evaluate(pos));
+                                  ops++;
+                              }
+                              return ops;
+                          }});
+
+    benchmarks.push_back({"evaluate_uncached", [&positions] {
+                              uint64_t ops = 0;
+                              for (Position& pos : positions)
+                              {
+                                  do_not_optimize(Engine::compute_static_eval(pos));
+                                  ops++;
+                              }
+                              return ops;
+                          }});
+
+    benchmarks.push_back({"fen_parse", [] {
+                              uint64_t ops = 0;
+                              for (const std::string& fen : CORPUS)
+                              {
+                                  Position pos{fen};
+                                  do_not_optimize(pos.zhash());
+                                  ops++;
+                              }
+                              return ops;
+                          }});
+
+    return benchmarks;
+}
+
+// nearest rank percentile of sorted values
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    size_t rank = static_cast<size_t>(p / 100.0 * sorted.size() + 0.999999);
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+static result measure(const benchmark& b, int samples, int warmup)
+{
+    // passes per sample: enough to take SAMPLE_MIN_TIME (the clock is too coarse for one pass of the fast ones)
+    uint64_t passes         = 1;
+    uint64_t ops_per_sample = 0;
+
+    // first pass is cold (caches, lazily built tables), it would throw the calibration off
+    b.run();
+
+    for (;;)
+    {
+        auto start     = bench_clock::now();
+        ops_per_sample = 0;
+
+        for (uint64_t i = 0; i < passes; i++)
+            ops_per_sample += b.run();
+
+        if (bench_clock::now() - start >= SAMPLE_MIN_TIME)
+            break;
+
+        passes *= 2;
+    }
+
+    std::vector<double> ns_per_op;
+
+    for (int s = 0; s < warmup + samples; s++)
+    {
+        auto start = bench_clock::now();
+
+        for (uint64_t i = 0; i < passes; i++)
+            b.run();
+
+        auto ns = std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+
+        if (s >= warmup)
+            ns_per_op.push_back(ns / ops_per_sample);
+    }
+
+    std::sort(ns_per_op.begin(), ns_per_op.end());
+
+    double sum = 0;
+    for (double ns : ns_per_op)
+        sum += ns;
+
+    return {b.name, ops_per_sample, percentile(ns_per_op, 50), percentile(ns_per_op, 99), sum / ns_per_op.size()};
+}
+
+// baseline file: "<name> <median ns/op>" lines
+static std::map<std::string, double> load_baseline(const std::string& path)
+{
+    std::map<std::string, double> baseline;
+    std::ifstream                 file{path};
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream stream{line};
+        std::string        name;
+        double             ns;
+
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        if (stream >> name >> ns)
+            baseline[name] = ns;
+    }
+
+    return baseline;
+}
+
+static bool save_baseline(const std::string& path, const std::vector<result>& results)
+{
+    std::ofstream file{path};
+
+    if (!file)
+        return false;
+
+    file << "# median ns/op per benchmark (written by bench --save)\n";
+
+    for (const result& r : results)
+        file << r.name << ' ' << std::fixed << std::setprecision(3) << r.median << '\n';
+
+    return bool(file);
+}
+
+static void usage()
+{
+    std::cerr << "usage: bench [--samples n] [--warmup n] [--filter substr] [--baseline file] [--save file] "
+                 "[--threshold percent]\n";
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    int         samples   = 30;
+    int         warmup    = 5;
+    double      threshold = 10.0; // percent slower than the baseline median to count as a regression
+    std::string filter;
+    std::string baseline_path;
+    std::string save_path;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (i + 1 >= argc)
+            usage();
+
+        std::string value = argv[++i];
+
+        if (arg == "--samples")
+            samples = std::max(1, atoi(value.c_str()));
+        else if (arg == "--warmup")
+            warmup = std::max(0, atoi(value.c_str()));
+        else if (arg == "--filter")
+            filter = value;
+        else if (arg == "--baseline")
+            baseline_path = value;
+        else if (arg == "--save")
+            save_path = value;
+        else if (arg == "--threshold")
+            threshold = atof(value.c_str());
+        else
+            usage();
+    }
+
+    Engine::init();
+
+    std::vector<Position> positions;
+    for (const std::string& fen : CORPUS)
+        positions.emplace_back(fen);
+
+    std::map<std::string, double> baseline;
+
+    if (!baseline_path.empty())
+    {
+        baseline = load_baseline(baseline_path);
+
+        if (baseline.empty())
+            std::cerr << "no baseline in " << baseline_path << " (make one with --save)\n";
+    }
+
+    std::cout << std::left << std::setw(20) << "benchmark" << std::right << std::setw(12) << "ops/sample"
+              << std::setw(12) << "median ns" << std::setw(12) << "p99 ns" << std::setw(12) << "mean ns";
+
+    if (!baseline.empty())
+        std::cout << std::setw(12) << "baseline" << std::setw(10) << "change";
+
+    std::cout << '\n';
+
+    std::vector<result> results;
+    int                 regressions = 0;
+
+    for (const benchmark& b : make_benchmarks(positions))
+    {
+        if (b.name.find(filter) == std::string::npos)
+            continue;
+
+        result r = measure(b, samples, warmup);
+        results.push_back(r);
+
+        std::cout << std::left << std::setw(20) << r.name << std::right << std::setw(12) << r.ops_per_sample
+                  << std::fixed << std::setprecision(2) << std::setw(12) << r.median << std::setw(12) << r.p99
+                  << std::setw(12) << r.mean;
+
+        auto it = baseline.find(r.name);
+
+        if (it != baseline.end())
+        {
+            double change = (r.median / it->second - 1.0) * 100.0;
+
+            std::cout << std::setw(12) << it->second << std::setw(9) << std::showpos << change << std::noshowpos
+                      << '%';
+
+            if (change > threshold)
+            {
+                std::cout << "  REGRESSION";
+                regressions++;
+            }
+        }
+
+        std::cout << std::endl;
+    }
+
+    if (!save_path.empty())
+    {
+        if (!save_baseline(save_path, results))
+        {
+            std::cerr << "couldn't write baseline " << save_path << '\n';
+            return 2;
+        }
+
+        std::cout << "baseline saved to " << save_path << '\n';
+    }
+
+    if (regressions)
+    {
+        std::cout << regressions << " benchmark(s) more than " << threshold << "% slower than the baseline\n";
+        return 1;
+    }
+
+    return 0;
+}
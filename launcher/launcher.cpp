@@ -0,0 +1,106 @@
+// runs the best chessengine release build for this cpu, from the same directory (make multi-isa builds them).
+// pgo builds are preferred over plain ones of the same isa. arguments are passed along, and the build
+// replaces this process, so stdin/stdout (uci) go straight to it.
+// a native build (-march=native) only runs on cpus like the one that built it, so it's only used when there
+// are no x86-64-vN builds at all, with a warning
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// unix std header
+#include <limits.h>
+#include <unistd.h>
+
+// x86-64 isa levels, as -march names them
+static int isa_level()
+{
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+
+    const bool v2 = __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("sse4.2") &&
+                    __builtin_cpu_supports("ssse3");
+
+    const bool v3 = v2 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") &&
+                    __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("fma");
+
+    const bool v4 = v3 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+                    __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl");
+
+    return v4 ? 4 : v3 ? 3 : v2 ? 2 : 1;
+#else
+    return 0;
+#endif
+}
+
+static std::string exe_dir()
+{
+    char    path[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+
+    if (len <= 0)
+        return ".";
+
+    path[len] = '\0';
+
+    std::string dir{path};
+    return dir.substr(0, dir.rfind('/'));
+}
+
+int main(int argc, char** argv)
+{
+    const std::string dir   = exe_dir();
+    const int         level = isa_level();
+
+    // best first
+    std::vector<std::string> candidates;
+
+    for (int l = level; l >= 2; l--)
+    {
+        const std::string name = dir + "/chessengine_release_x86-64-v" + std::to_string(l);
+        candidates.push_back(name + "_pgo");
+        candidates.push_back(name);
+    }
+
+    // builds for a newer cpu than this one don't run here, but they mean multi-isa was built: don't fall back to native
+    bool isa_builds = false;
+
+    for (int l = 2; l <= 4; l++)
+    {
+        const std::string name = dir + "/chessengine_release_x86-64-v" + std::to_string(l);
+        isa_builds |= access((name + "_pgo").c_str(), X_OK) == 0 || access(name.c_str(), X_OK) == 0;
+    }
+
+    if (!isa_builds)
+    {
+        candidates.push_back(dir + "/chessengine_release_pgo");
+        candidates.push_back(dir + "/chessengine_release");
+    }
+
+    for (const std::string& path : candidates)
+    {
+        if (access(path.c_str(), X_OK) != 0)
+            continue;
+
+        if (!isa_builds)
+            std::cerr << "warning: no x86-64-vN builds in " << dir << ", running the native build " << path
+                      << " (it crashes on cpus unlike the one that built it)\n";
+
+        std::vector<char*> args{const_cast<char*>(path.c_str())};
+
+        for (int i = 1; i < argc; i++)
+            args.push_back(argv[i]);
+
+        args.push_back(nullptr);
+
+        execv(path.c_str(), args.data());
+
+        std::cerr << "couldn't run " << path << ": " << strerror(errno) << '\n';
+        return 1;
+    }
+
+    std::cerr << "no chessengine build for this cpu in " << dir << " (build them with make multi-isa)\n";
+    return 1;
+}
@@ -0,0 +1,210 @@
+#include "batch.hpp"
+#include "epd.hpp"
+#include "instance.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// entries in each thread's table. kept between positions: entries are checked by hash, so they're never wrong
+static constexpr size_t BATCH_TT_ENTRIES = (1 << 18);
+
+// positions read ahead of the output, per thread (bounds memory, however big the file)
+static constexpr size_t READ_AHEAD_PER_THREAD = 64;
+
+struct job
+{
+    size_t      index; // output order: the number of the position in the file
+    size_t      line_num;
+    std::string fen;
+    std::string id;
+};
+
+struct batch_state
+{
+    std::mutex              mutex;
+    std::condition_variable job_available;
+    std::condition_variable space_available;
+
+    std::deque<job> jobs;
+    bool            done_reading = false;
+
+    // finished lines, waiting for the ones before them
+    std::map<size_t, std::string> results;
+    size_t                        next_output = 0; // index of the next position to write
+    size_t                        in_flight   = 0; // read, but not written
+
+    uint64_t total_nodes = 0;
+};
+
+static std::string json_string(const std::string& str)
+{
+    std::string escaped = "\"";
+
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+
+        escaped += c;
+    }
+
+    return escaped + '"';
+}
+
+// score, and moves to mate if it's a mate score
+static std::string json_score(Engine::centipawn score)
+{
+    std::string json = ",\"score\":" + std::to_string(score);
+
+    if (Engine::is_mate_score(score))
+        json += ",\"mate\":" + std::to_string(Engine::mate_moves(score));
+
+    return json;
+}
+
+static std::string analyse(Engine::instance& engine, const job& j, int depth, uint64_t& nodes)
+{
+    std::string json = "{\"line\":" + std::to_string(j.line_num) + ",\"fen\":" + json_string(j.fen);
+
+    if (!j.id.empty())
+        json += ",\"id\":" + json_string(j.id);
+
+    // a bad line is reported, and the rest of the file still analysed
+    std::string error;
+
+    if (!Position::validate_fen(j.fen, error))
+        return json + ",\"error\":" + json_string(error) + "}";
+
+    engine.set_fen(j.fen);
+
+    if (Engine::game_state(engine.position()) != Engine::GAME_STATE::ONGOING)
+        return json + ",\"bestmove\":null" + json_score(Engine::evaluate(engine.position())) + ",\"depth\":0,\"nodes\":0}";
+
+    const Search::search_info info = engine.search(depth);
+
+    nodes = info.nodes_searched;
+
+    return json + ",\"bestmove\":\"" + info.best_move.to_str() + "\"" + json_score(info.score)
+         + ",\"depth\":" + std::to_string(depth) + ",\"nodes\":" + std::to_string(info.nodes_searched) + "}";
+}
+
+static void worker(batch_state& state, int depth)
+{
+    Engine::instance engine{BATCH_TT_ENTRIES};
+
+    std::unique_lock<std::mutex> lock{state.mutex};
+
+    while (true)
+    {
+        state.job_available.wait(lock, [&] { return state.done_reading || !state.jobs.empty(); });
+
+        if (state.jobs.empty())
+            return;
+
+        const job j = std::move(state.jobs.front());
+        state.jobs.pop_front();
+
+        lock.unlock();
+
+        uint64_t          nodes  = 0;
+        const std::string result = analyse(engine, j, depth, nodes);
+
+        lock.lock();
+
+        state.total_nodes += nodes;
+        state.results.emplace(j.index, result);
+
+        // write whatever is now in order
+        bool wrote = false;
+
+        for (auto it = state.results.begin(); it != state.results.end() && it->first == state.next_output;
+             it  = state.results.erase(it))
+        {
+            std::cout << it->second << '\n';
+
+            state.next_output++;
+            state.in_flight--;
+            wrote = true;
+        }
+
+        if (wrote)
+            state.space_available.notify_one();
+    }
+}
+
+bool Batch::run(const std::string& path, int depth, int threads)
+{
+    std::ifstream file{path};
+
+    if (!file)
+        return false;
+
+    threads = std::max(1, threads);
+    depth   = std::max(1, depth);
+
+    Engine::init();
+
+    const auto start = std::chrono::steady_clock::now();
+
+    batch_state state;
+
+    std::vector<std::thread> workers;
+
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(worker, std::ref(state), depth);
+
+    const size_t max_in_flight = READ_AHEAD_PER_THREAD * threads;
+
+    size_t positions = 0;
+    size_t line_num  = 0;
+
+    for (std::string line; std::getline(file, line);)
+    {
+        line_num++;
+
+        job j{positions, line_num, "", ""};
+
+        // not a position (empty line or comment)
+        if (!Epd::parse_line(line, j.fen, j.id))
+            continue;
+
+        positions++;
+
+        std::unique_lock<std::mutex> lock{state.mutex};
+
+        state.space_available.wait(lock, [&] { return state.in_flight < max_in_flight; });
+
+        state.in_flight++;
+        state.jobs.push_back(std::move(j));
+        state.job_available.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{state.mutex};
+        state.done_reading = true;
+        state.job_available.notify_all();
+    }
+
+    for (std::thread& t : workers)
+        t.join();
+
+    std::cout << std::flush;
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cerr << "batch: " << positions << " positions, depth " << depth << ", " << threads << " threads, " << seconds
+              << " s (" << static_cast<uint64_t>(positions / seconds) << " positions/s, "
+              << static_cast<uint64_t>(state.total_nodes / seconds) << " nodes/s)\n";
+
+    return true;
+}
@@ -0,0 +1,19 @@
+#ifndef BATCH_INCL
+#define BATCH_INCL
+
+#include <string>
+
+// Batch analysis: search every position of an EPD or FEN file (one per line) to a fixed depth, on many threads.
+// Each thread has it's own engine instance. Results are written to stdout as JSON lines, in input order:
+//   {"line":1,"fen":"...","id":"...","bestmove":"e2e4","score":25,"depth":6,"nodes":12345}
+// ("id" only if the EPD line has one, bestmove is null when the game is over). Blank lines and '#' comments are
+// skipped, a line with an invalid position is written as {"line":2,"fen":"...","error":"..."}. A summary goes to stderr
+namespace Batch
+{
+
+// false if the file can't be read
+bool run(const std::string& path, int depth, int threads);
+
+} // namespace Batch
+
+#endif // BATCH_INCL
@@ -0,0 +1,259 @@
+#include "bitbase.hpp"
+#include "movegen.hpp"
+#include "position.hpp"
+
+#include <cassert>
+#include <mutex>
+#include <vector>
+
+// The side with the extra piece is made white (mirroring the board if needed), then positions are indexed by
+// side to move (0: white), white king, black king and the piece square
+static constexpr size_t BITBASE_SIZE = 2 * 64 * 64 * 64;
+
+static size_t bitbase_index(int stm, square wk, square bk, square psq)
+{
+    return stm | (wk << 1) | (bk << 7) | (static_cast<size_t>(psq) << 13);
+}
+
+// one bit per position: white wins
+struct bitbase
+{
+    std::vector<uint64_t> wins = std::vector<uint64_t>(BITBASE_SIZE / 64, 0);
+
+    bool win(size_t idx) const { return wins[idx / 64] & (1ULL << (idx % 64)); }
+};
+
+// index with the extra PIECE (PAWN, ROOK or QUEEN)
+static bitbase         bitbases[QUEEN + 1];
+static std::once_flag  generated;
+
+// ------------------ GENERATION -----------------------
+
+enum RETRO_RESULT : uint8_t
+{
+    R_UNKNOWN,
+    R_INVALID,
+    R_DRAW,
+    R_WIN
+};
+
+// squares the white piece attacks (for a pawn: captures)
+static bitboard piece_attacks(PIECE p, square sq, bitboard occ)
+{
+    switch (p)
+    {
+    case PAWN:
+        return bb_pawn_attacks_e(bb_from_sq(sq), ~BB_ZERO, WHITE) | bb_pawn_attacks_w(bb_from_sq(sq), ~BB_ZERO, WHITE);
+    case ROOK:
+        return bb_rook_moves(sq, occ);
+    case QUEEN:
+        return bb_queen_moves(sq, occ);
+    default:
+        assert(false);
+        return BB_ZERO;
+    }
+}
+
+// positions that are illegal, or decided without looking at moves
+static RETRO_RESULT initial_result(PIECE p, int stm, square wk, square bk, square psq)
+{
+    if (wk == bk || wk == psq || bk == psq)
+        return R_INVALID;
+
+    if (bb_king_moves(wk) & bb_from_sq(bk))
+        return R_INVALID;
+
+    if (p == PAWN && (rank_num(psq) == 1 || rank_num(psq) == 8))
+        return R_INVALID;
+
+    const bitboard bk_bb    = bb_from_sq(bk);
+    const bitboard attacked = piece_attacks(p, psq, bb_from_sq(wk) | bk_bb);
+
+    // black is in check, and it's white's move
+    if (stm == WHITE)
+        return (attacked & bk_bb) ? R_INVALID : R_UNKNOWN;
+
+    // black can take the last piece
+    if ((bb_king_moves(bk) & bb_from_sq(psq)) && !(bb_king_moves(wk) & bb_from_sq(psq)))
+        return R_DRAW;
+
+    // without black's king in the way, so it can't step back along a ray
+    const bitboard covered = bb_king_moves(wk) | piece_attacks(p, psq, bb_from_sq(wk)) | bb_from_sq(psq);
+
+    if (bb_king_moves(bk) & ~covered)
+        return R_UNKNOWN;
+
+    return (attacked & bk_bb) ? R_WIN : R_DRAW;
+}
+
+// does white win by promoting the pawn on psq (black to move after)? a queen usually, a rook when the queen stalemates
+static bool promotion_wins(square wk, square bk, square psq)
+{
+    const square promo_sq = psq + NORTH;
+
+    if (rank_num(promo_sq) != 8 || promo_sq == wk || promo_sq == bk)
+        return false;
+
+    return bitbases[QUEEN].win(bitbase_index(BLACK, wk, bk, promo_sq))
+        || bitbases[ROOK].win(bitbase_index(BLACK, wk, bk, promo_sq));
+}
+
+// squares the piece can have come from to psq (with white to move before)
+static bitboard piece_origins(PIECE p, square psq, bitboard occ)
+{
+    if (p != PAWN)
+        return piece_attacks(p, psq, occ) & ~occ;
+
+    bitboard origins = BB_ZERO;
+
+    const square single = psq - NORTH;
+
+    if (rank_num(single) >= 2 && !(occ & bb_from_sq(single)))
+    {
+        origins |= bb_from_sq(single);
+
+        const square double_push = single - NORTH;
+
+        if (rank_num(double_push) == 2 && !(occ & bb_from_sq(double_push)))
+            origins |= bb_from_sq(double_push);
+    }
+
+    return origins;
+}
+
+// Retrograde analysis: starting from the checkmates (and winning promotions), walk backwards through the moves.
+// A white to move position is won if any move wins, a black to move position when every move loses.
+// Every position is visited once, when it's found to be won. Whatever isn't won at the end is a draw
+static void generate(PIECE p)
+{
+    std::vector<uint8_t> results(BITBASE_SIZE);
+
+    // black to move: moves that aren't known to lose yet
+    std::vector<uint8_t> moves_left(BITBASE_SIZE, 0);
+
+    // won positions, whose predecessors haven't been looked at
+    std::vector<uint32_t> queue;
+
+    for (size_t idx = 0; idx < BITBASE_SIZE; idx++)
+    {
+        const square wk  = (idx >> 1) & 63;
+        const square bk  = (idx >> 7) & 63;
+        const square psq = idx >> 13;
+
+        results[idx] = initial_result(p, idx & 1, wk, bk, psq);
+
+        if (results[idx] == R_UNKNOWN && (idx & 1) == BLACK)
+        {
+            const bitboard covered = bb_king_moves(wk) | piece_attacks(p, psq, bb_from_sq(wk)) | bb_from_sq(psq);
+            moves_left[idx]        = popcnt(bb_king_moves(bk) & ~covered);
+        }
+
+        if (results[idx] == R_UNKNOWN && (idx & 1) == WHITE && p == PAWN && promotion_wins(wk, bk, psq))
+            results[idx] = R_WIN;
+
+        if (results[idx] == R_WIN)
+            queue.push_back(idx);
+    }
+
+    while (!queue.empty())
+    {
+        const uint32_t idx = queue.back();
+        queue.pop_back();
+
+        const square wk  = (idx >> 1) & 63;
+        const square bk  = (idx >> 7) & 63;
+        const square psq = idx >> 13;
+
+        if ((idx & 1) == BLACK)
+        {
+            // white moved here, so white wins in the position before
+            const bitboard occ = bb_from_sq(wk) | bb_from_sq(bk) | bb_from_sq(psq);
+
+            bitboard king_origins  = bb_king_moves(wk) & ~occ;
+            bitboard piece_origins_bb = piece_origins(p, psq, occ);
+
+            while (king_origins || piece_origins_bb)
+            {
+                const size_t prev = king_origins ? bitbase_index(WHITE, pop_lsb(king_origins), bk, psq)
+                                                 : bitbase_index(WHITE, wk, bk, pop_lsb(piece_origins_bb));
+
+                if (results[prev] == R_UNKNOWN)
+                {
+                    results[prev] = R_WIN;
+                    queue.push_back(prev);
+                }
+            }
+        }
+        else
+        {
+            // black moved here: one less move to escape with in the position before
+            bitboard king_origins = bb_king_moves(bk) & ~(bb_from_sq(wk) | bb_from_sq(psq));
+
+            while (king_origins)
+            {
+                const size_t prev = bitbase_index(BLACK, wk, pop_lsb(king_origins), psq);
+
+                if (results[prev] == R_UNKNOWN && --moves_left[prev] == 0)
+                {
+                    results[prev] = R_WIN;
+                    queue.push_back(prev);
+                }
+            }
+        }
+    }
+
+    for (size_t idx = 0; idx < BITBASE_SIZE; idx++)
+        if (results[idx] == R_WIN)
+            bitbases[p].wins[idx / 64] |= 1ULL << (idx % 64);
+}
+
+void Bitbase::init()
+{
+    // pawn promotions look up the queen and rook bitbases
+    std::call_once(generated, [] {
+        generate(QUEEN);
+        generate(ROOK);
+        generate(PAWN);
+    });
+}
+
+// ------------------ PROBING -----------------------
+
+Bitbase::RESULT Bitbase::probe(const Position& pos)
+{
+    if (popcnt(pos.pieces()) != 3)
+        return RESULT::UNKNOWN;
+
+    // the side with the extra piece
+    const COLOR strong = popcnt(pos.pieces(WHITE)) == 2 ? WHITE : BLACK;
+
+    PIECE p = NO_PIECE;
+
+    for (PIECE candidate : {PAWN, ROOK, QUEEN})
+        if (pos.pieces(strong, candidate))
+            p = candidate;
+
+    if (p == NO_PIECE)
+        return RESULT::UNKNOWN;
+
+    init();
+
+    square wk  = lsb(pos.pieces(strong, KING));
+    square bk  = lsb(pos.pieces(!strong, KING));
+    square psq = lsb(pos.pieces(strong, p));
+
+    // make the strong side white
+    if (strong == BLACK)
+    {
+        wk  = mirror_vertically(wk);
+        bk  = mirror_vertically(bk);
+        psq = mirror_vertically(psq);
+    }
+
+    const bool strong_to_move = pos.side_to_move() == strong;
+
+    if (!bitbases[p].win(bitbase_index(strong_to_move ? WHITE : BLACK, wk, bk, psq)))
+        return RESULT::DRAW;
+
+    return strong_to_move ? RESULT::WIN : RESULT::LOSS;
+}
@@ -0,0 +1,31 @@
+#ifndef BITBASE_INCL
+#define BITBASE_INCL
+
+#include <cstdint>
+
+class Position;
+
+// Win/draw bitbases for the smallest endgames: king and queen, rook or pawn against a lone king.
+// They are generated by retrograde analysis the first time they are needed (no tablebase files),
+// and stored as one bit per position: does the side with the extra piece win?
+namespace Bitbase
+{
+
+enum class RESULT
+{
+    UNKNOWN, // not a bitbase position
+    DRAW,
+    WIN, // side to move wins
+    LOSS // side to move loses
+};
+
+// generate all bitbases now, instead of on first probe
+void init();
+
+// exact result of the position if it is in a bitbase. positions with a capture of the last piece,
+// checkmate and stalemate are included, but the 50 move rule isn't
+RESULT probe(const Position& pos);
+
+} // namespace Bitbase
+
+#endif // BITBASE_INCL
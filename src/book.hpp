@@ -0,0 +1,40 @@
+#ifndef BOOK_INCL
+#define BOOK_INCL
+
+#include "chessmove.hpp"
+
+#include <cstdint>
+#include <string>
+
+class Position;
+
+// Polyglot opening book (.bin) probing.
+// A book is a sorted array of 16 byte entries (key, move, weight, learn), all big endian.
+// The file is memory mapped, and the entries of a position are found by binary search on the key.
+namespace Book
+{
+
+// how to choose between the book moves of a position
+enum class SELECTION
+{
+    WEIGHTED, // random, with probability proportional to weight
+    BEST      // always the highest weight (reproducible)
+};
+
+// map the book file, closing the current book. On failure no book is open and false is returned
+bool open(const std::string& path);
+void close();
+bool is_open();
+
+// polyglot hash of the position (uses the standard polyglot keys, not ours)
+uint64_t polyglot_key(const Position& pos);
+
+// a legal book move for the position, or a null move if the position isn't in the book
+ChessMove probe(Position& pos, SELECTION selection);
+
+// print the key and every book move of the position, with weights
+void dump(Position& pos);
+
+} // namespace Book
+
+#endif // BOOK_INCL
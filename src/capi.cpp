@@ -0,0 +1,122 @@
+#include "chessengine.h"
+#include "instance.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// the C handle is the instance
+struct ce_engine
+{
+    Engine::instance instance;
+
+    explicit ce_engine(size_t tt_entries) : instance(tt_entries) {}
+};
+
+// copy str to buf, as much as fits (always null terminated, if there's room for anything)
+static void copy_truncated(const std::string& str, char* buf, size_t size)
+{
+    if (buf == nullptr || size == 0)
+        return;
+
+    const size_t n = std::min(str.size(), size - 1);
+    std::memcpy(buf, str.data(), n);
+    buf[n] = '\0';
+}
+
+static ce_search_info to_c_info(const Search::search_info& info)
+{
+    ce_search_info c_info{};
+
+    c_info.depth = info.depth;
+    c_info.score = info.score;
+    c_info.nodes = info.nodes_searched;
+    c_info.mate  = Engine::is_mate_score(info.score) ? Engine::mate_moves(info.score) : 0;
+    copy_truncated(info.best_move.to_str(), c_info.best_move, sizeof(c_info.best_move));
+
+    return c_info;
+}
+
+void ce_init(void) { Engine::init(); }
+
+ce_engine* ce_new(size_t tt_entries)
+{
+    if (tt_entries == 0)
+        tt_entries = Engine::DEFAULT_INSTANCE_TT_ENTRIES;
+
+    // must be a power of 2
+    if ((tt_entries & (tt_entries - 1)) != 0)
+        return nullptr;
+
+    return new ce_engine(tt_entries);
+}
+
+void ce_free(ce_engine* engine) { delete engine; }
+
+int ce_set_fen(ce_engine* engine, const char* fen) { return fen != nullptr && engine->instance.set_fen(fen); }
+
+size_t ce_get_fen(ce_engine* engine, char* buf, size_t size)
+{
+    const std::string fen = engine->instance.position().FEN();
+
+    copy_truncated(fen, buf, size);
+    return fen.size();
+}
+
+int ce_legal_moves(ce_engine* engine, char* buf, size_t size)
+{
+    const move_list moves = engine->instance.legal_moves();
+
+    std::string move_str;
+
+    for (const ChessMove& m : moves)
+        move_str += (move_str.empty() ? "" : " ") + m.to_str();
+
+    copy_truncated(move_str, buf, size);
+    return static_cast<int>(moves.size());
+}
+
+int ce_make_move(ce_engine* engine, const char* uci_move) { return engine->instance.make_move(uci_move); }
+
+int ce_unmake_move(ce_engine* engine) { return engine->instance.unmake_move(); }
+
+int32_t ce_evaluate(ce_engine* engine) { return engine->instance.evaluate(); }
+
+uint64_t ce_perft(ce_engine* engine, int depth) { return engine->instance.perft(depth); }
+
+int ce_search(ce_engine* engine, const ce_limits* limits, ce_info_callback on_info, void* user_data,
+              ce_search_info* result)
+{
+    if (limits == nullptr || limits->depth < 0 || limits->mate < 0 || limits->movetime < 0)
+        return 0;
+
+    const bool limited = limits->depth || limits->nodes || limits->mate || limits->movetime || limits->infinite;
+
+    if (!limited || engine->instance.legal_moves().empty())
+        return 0;
+
+    Search::search_params params;
+
+    params.depth    = limits->depth ? std::min(limits->depth, Search::MAX_PLY) : Search::MAX_PLY;
+    params.nodes    = limits->nodes;
+    params.mate     = limits->mate;
+    params.movetime = limits->movetime;
+
+    Search::info_callback callback;
+
+    if (on_info != nullptr)
+        callback = [&](const Search::search_info& info) {
+            const ce_search_info c_info = to_c_info(info);
+            on_info(&c_info, user_data);
+        };
+
+    const Search::search_info info = engine->instance.search(params, callback);
+
+    if (result != nullptr)
+        *result = to_c_info(info);
+
+    return 1;
+}
+
+void ce_stop(ce_engine* engine) { engine->instance.stop(); }
+
+void ce_new_game(ce_engine* engine) { engine->instance.new_game(); }
@@ -0,0 +1,85 @@
+#ifndef CHESSENGINE_H_INCL
+#define CHESSENGINE_H_INCL
+
+/* C interface of the engine library (output/libchessengine*), for FFI.
+ * Every function taking an engine is wrapping an Engine::instance (see instance.hpp): engines are independent,
+ * and can be used from different threads, but one engine only from one thread at a time.
+ * Moves are in uci format (e2e4, e7e8q) */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ce_engine ce_engine;
+
+typedef struct ce_search_info
+{
+    int      depth;
+    int32_t  score; /* centipawns, relative to side to move */
+    uint64_t nodes;
+    char     best_move[6];
+    int32_t  mate; /* moves to mate (negative: the side to move is mated), 0 if score isn't a mate */
+} ce_search_info;
+
+/* what ends a search: the first limit reached, or ce_stop. 0 is no limit.
+ * a search with no limit at all (and not infinite) is an error */
+typedef struct ce_limits
+{
+    int      depth;
+    uint64_t nodes;
+    int      mate;     /* look for a mate in this many moves */
+    int64_t  movetime; /* milliseconds */
+    int      infinite; /* nonzero: search until ce_stop */
+} ce_limits;
+
+/* called when each depth of a search is done */
+typedef void (*ce_info_callback)(const ce_search_info* info, void* user_data);
+
+/* initialize the global tables. ce_new does it too, thread safe and only done once */
+void ce_init(void);
+
+/* new engine at the starting position, with a transposition table of tt_entries (a power of 2, 0: default) */
+ce_engine* ce_new(size_t tt_entries);
+void       ce_free(ce_engine* engine);
+
+/* returns 0 (and the position is unchanged) if the fen is invalid */
+int ce_set_fen(ce_engine* engine, const char* fen);
+
+/* fen of the current position, written to buf (truncated to size). returns the full length */
+size_t ce_get_fen(ce_engine* engine, char* buf, size_t size);
+
+/* legal moves, space separated, written to buf (truncated to size). returns the number of moves */
+int ce_legal_moves(ce_engine* engine, char* buf, size_t size);
+
+/* returns 1 if the move was legal and made, 0 otherwise */
+int ce_make_move(ce_engine* engine, const char* uci_move);
+
+/* take back the last move. returns 0 if there is none */
+int ce_unmake_move(ce_engine* engine);
+
+/* centipawns, relative to side to move */
+int32_t ce_evaluate(ce_engine* engine);
+
+uint64_t ce_perft(ce_engine* engine, int depth);
+
+/* search until a limit is reached. on_info may be NULL.
+ * returns 0 (and searches nothing) if there's no legal move or no limit */
+int ce_search(ce_engine* engine, const ce_limits* limits, ce_info_callback on_info, void* user_data,
+              ce_search_info* result);
+
+/* stop the engine's search, ce_search returns the result of the last depth it finished.
+ * if no search is running, the next one stops as soon as it starts.
+ * unlike the other functions, this can be called from another thread while the engine searches */
+void ce_stop(ce_engine* engine);
+
+/* forget the transposition table, the next position is from a new game */
+void ce_new_game(ce_engine* engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHESSENGINE_H_INCL */
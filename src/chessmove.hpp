@@ -69,7 +69,7 @@ class ChessMove
     inline bool is_en_passante() const { return m_cap_piece == EN_PASSANTE; }
 
     // ie initialized, but not valid
-    inline bool is_null() { return m_moved_piece == NO_PIECE; }
+    inline bool is_null() const { return m_moved_piece == NO_PIECE; }
 
     inline std::string to_str() const
     {
@@ -0,0 +1,112 @@
+#include "cuckoo.hpp"
+#include "movegen.hpp"
+#include "types/pieces.hpp"
+
+#include <array>
+#include <cassert>
+#include <utility>
+
+// a reversible move: the piece moving isn't stored, the board tells us which piece it is
+struct cuckoo_move
+{
+    square sq1 = 0;
+    square sq2 = 0;
+
+    bool empty() const { return sq1 == sq2; }
+};
+
+// must be power of 2 size, and big enough for the 3668 reversible moves
+static constexpr size_t cuckoo_size       = (1 << 13);
+static constexpr size_t cuckoo_index_mask = cuckoo_size - 1;
+
+static std::array<zhash_t, cuckoo_size>     cuckoo_keys{};
+static std::array<cuckoo_move, cuckoo_size> cuckoo_moves{};
+
+// the two hash functions: each key can be in one of two slots
+static size_t h1(zhash_t key) { return key & cuckoo_index_mask; }
+static size_t h2(zhash_t key) { return (key >> 16) & cuckoo_index_mask; }
+
+// moves of p from sq on an empty board
+static bitboard empty_board_moves(PIECE p, square sq)
+{
+    switch (p)
+    {
+    case KNIGHT:
+        return bb_knight_moves(sq);
+    case BISHOP:
+        return bb_bishop_moves(sq, BB_ZERO);
+    case ROOK:
+        return bb_rook_moves(sq, BB_ZERO);
+    case QUEEN:
+        return bb_queen_moves(sq, BB_ZERO);
+    case KING:
+        return bb_king_moves(sq);
+    default:
+        return BB_ZERO;
+    }
+}
+
+void Cuckoo::init()
+{
+    cuckoo_keys.fill(0);
+    cuckoo_moves.fill(cuckoo_move{});
+
+    [[maybe_unused]] int count = 0;
+
+    for (COLOR c : {WHITE, BLACK})
+    {
+        for (int p = KNIGHT; p <= KING; p++)
+        {
+            const PIECE piece = static_cast<PIECE>(p);
+
+            for (square sq1 = 0; sq1 < 64; sq1++)
+            {
+                for (square sq2 = sq1 + 1; sq2 < 64; sq2++)
+                {
+                    if (!bb_is_set_at_sq(empty_board_moves(piece, sq1), sq2))
+                        continue;
+
+                    zhash_t key = Zobrist::color_piece_on_sq(c, piece, sq1) ^ Zobrist::color_piece_on_sq(c, piece, sq2)
+                                ^ Zobrist::black_to_move();
+
+                    cuckoo_move move{sq1, sq2};
+
+                    // insert, kicking out whatever is in the slot to its other slot, until a slot was empty
+                    size_t i = h1(key);
+
+                    while (true)
+                    {
+                        std::swap(cuckoo_keys[i], key);
+                        std::swap(cuckoo_moves[i], move);
+
+                        if (move.empty())
+                            break;
+
+                        i = (i == h1(key)) ? h2(key) : h1(key);
+                    }
+
+                    count++;
+                }
+            }
+        }
+    }
+
+    assert(count == 3668);
+}
+
+bool Cuckoo::lookup(zhash_t key, square& sq1, square& sq2)
+{
+    size_t i = h1(key);
+
+    if (cuckoo_keys[i] != key || cuckoo_moves[i].empty())
+    {
+        i = h2(key);
+
+        if (cuckoo_keys[i] != key || cuckoo_moves[i].empty())
+            return false;
+    }
+
+    sq1 = cuckoo_moves[i].sq1;
+    sq2 = cuckoo_moves[i].sq2;
+    return true;
+}
@@ -0,0 +1,24 @@
+#ifndef CUCKOO_INCL
+#define CUCKOO_INCL
+
+#include "./types/bitboard.hpp"
+#include "zobrist.hpp"
+
+// Every reversible move (a non-pawn piece moving between two squares, either direction) changes the
+// position hash by a fixed key: the piece on both squares, and the side to move.
+// These keys are stored in a cuckoo hash table, so we can recognize the hash difference between two
+// positions in the history as "one move apart" with two probes.
+// Used to detect a repetition one move before it happens (Marcel van Kervinck's method).
+namespace Cuckoo
+{
+
+// build the table (after Zobrist::init and the slider tables)
+void init();
+
+// if key is the hash difference of a reversible move, set the two squares of the move and return true.
+// the move can go in either direction: the squares are only in order of the table, not from/to
+bool lookup(zhash_t key, square& sq1, square& sq2);
+
+} // namespace Cuckoo
+
+#endif // CUCKOO_INCL
@@ -1,75 +1,566 @@
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <bits/chrono.h>
 #include <cassert>
+#include <cctype>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
 #include <sstream>
 #include <string>
+#include <thread>
 
 #include "./types/bitboard.hpp"
+#include "batch.hpp"
+#include "book.hpp"
 #include "chessmove.hpp"
+#include "cuckoo.hpp"
 #include "engine.hpp"
 #include "evaluate.hpp"
 #include "gameinfo.hpp"
+#include "instance.hpp"
+#include "match.hpp"
 #include "movegen.hpp"
+#include "nnue.hpp"
 #include "perft.hpp"
 #include "position.hpp"
 #include "search.hpp"
+#include "stats.hpp"
+#include "server.hpp"
 #include "transposition.hpp"
+#include "zobrist.hpp"
 
 static bool interactive = false;
 
+void Engine::init()
+{
+    static std::once_flag initialized;
+
+    std::call_once(initialized, [] {
+        init_slider_tables(best_slider_backend());
+        Zobrist::init();
+        Cuckoo::init();
+        nnue::init();
+    });
+}
+
 void Engine::set_interactive() { interactive = true; }
 
-// send "info string" message - omit "info string" if interactive
-static void send_info(std::string message)
+// "info string" message - omit "info string" if interactive
+static std::string info_string(const std::string& message) { return interactive ? message : "info string " + message; }
+
+// send "info string" message
+static void send_info(std::string message) { std::cout << info_string(message) << '\n'; }
+
+// the search's output goes through a queue, written (and flushed) by a thread of it's own:
+// the search never waits for the gui to read it's output, and lines still come out in order
+class output_queue
 {
-    if (!interactive)
-        std::cout << "info string ";
-    std::cout << message << '\n';
+  public:
+    output_queue() : m_thread([this] { write_loop(); }) {}
+
+    ~output_queue()
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_done = true;
+        }
+
+        m_available.notify_one();
+        m_thread.join();
+    }
+
+    void send(std::string line)
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_lines.push_back(std::move(line));
+        }
+
+        m_available.notify_one();
+    }
+
+    // wait until everything sent is written
+    void flush()
+    {
+        std::unique_lock lock{m_mutex};
+        m_written.wait(lock, [this] { return m_lines.empty() && !m_writing; });
+    }
+
+  private:
+    void write_loop()
+    {
+        std::unique_lock lock{m_mutex};
+
+        for (;;)
+        {
+            m_available.wait(lock, [this] { return !m_lines.empty() || m_done; });
+
+            if (m_lines.empty())
+                return;
+
+            std::deque<std::string> lines;
+            lines.swap(m_lines);
+            m_writing = true;
+
+            lock.unlock();
+
+            for (const std::string& line : lines)
+                std::cout << line << '\n';
+
+            std::cout.flush();
+
+            lock.lock();
+            m_writing = false;
+            m_written.notify_all();
+        }
+    }
+
+    std::mutex              m_mutex;
+    std::condition_variable m_available;
+    std::condition_variable m_written;
+    std::deque<std::string> m_lines;
+    bool                    m_writing = false;
+    bool                    m_done    = false;
+
+    // last, so everything it uses exists when it starts
+    std::thread m_thread;
+};
+
+// started on first use, the modes without a search never need it
+static output_queue& output()
+{
+    static output_queue queue;
+    return queue;
+}
+
+// an option the GUI can change with setoption. on_set is called with the new value
+struct uci_option
+{
+    std::string                             name;
+    std::string                             type; // check, spin, string, combo
+    std::string                             default_value;
+    std::function<void(const std::string&)> on_set;
+    std::vector<std::string>                vars = {}; // choices of a combo
+    int                                     min  = 0;  // range of a spin
+    int                                     max  = 0;
+};
+
+static const std::string EMBEDDED_NET = "<embedded>";
+static const std::string NO_TT_FILE   = "<empty>";
+static const std::string NO_BOOK_FILE = "<empty>";
+
+static bool              own_book       = false;
+static Book::SELECTION   book_selection = Book::SELECTION::WEIGHTED;
+
+// best lines the search finds and reports (MultiPV option)
+constexpr int MAX_MULTIPV = 256;
+static int    multipv     = 1;
+
+// shallow depth pruning in the search (options, so the margins can be tuned in self-play)
+static Search::pruning_params pruning;
+
+// option default: the search's default
+static std::string pruning_default(int Search::pruning_params::*field)
+{
+    return std::to_string(Search::pruning_params{}.*field);
 }
 
+// transposition table file new games start from (set with the TTFile option)
+static std::string tt_file = NO_TT_FILE;
+
+// empty the transposition table, or go back to the one saved in tt_file
+static void reset_tt()
+{
+    if (tt_file == NO_TT_FILE)
+        tt::init();
+    else if (!tt::load(tt_file))
+    {
+        send_info("failed to load transposition table from " + tt_file + ", starting empty");
+        tt::init();
+    }
+}
+
+static const std::vector<uci_option> options = {
+    {"UseNNUE", "check", "false",
+     [](const std::string& value) {
+         nnue::set_enabled(value == "true");
+         Engine::clear_eval_cache();
+     }},
+    {"EvalFile", "string", EMBEDDED_NET,
+     [](const std::string& value) {
+         if (value == EMBEDDED_NET)
+             nnue::init();
+         else if (!nnue::load(value))
+             send_info("failed to load network from " + value + ", keeping the previous network");
+
+         Engine::clear_eval_cache();
+     }},
+    {"SliderBackend", "combo", "auto",
+     [](const std::string& value) {
+         SLIDER_BACKEND backend = best_slider_backend();
+
+         if (value == "pext")
+             backend = SLIDER_BACKEND::PEXT;
+         else if (value == "magic")
+             backend = SLIDER_BACKEND::MAGIC;
+
+         if (!slider_backend_supported(backend))
+         {
+             send_info("pext isn't supported by this build (needs a bmi2 isa), using magic");
+             backend = SLIDER_BACKEND::MAGIC;
+         }
+
+         init_slider_tables(backend);
+     },
+     {"auto", "pext", "magic"}},
+    {"TTFile", "string", NO_TT_FILE,
+     [](const std::string& value) {
+         tt_file = value;
+         reset_tt();
+     }},
+    {"OwnBook", "check", "false", [](const std::string& value) { own_book = value == "true"; }},
+    {"BookFile", "string", NO_BOOK_FILE,
+     [](const std::string& value) {
+         if (value == NO_BOOK_FILE)
+             Book::close();
+         else if (!Book::open(value))
+             send_info("failed to open book " + value);
+     }},
+    {"BookSelection", "combo", "weighted",
+     [](const std::string& value) {
+         book_selection = value == "best" ? Book::SELECTION::BEST : Book::SELECTION::WEIGHTED;
+     },
+     {"weighted", "best"}},
+    {"MultiPV", "spin", "1", [](const std::string& value) { multipv = std::clamp(std::stoi(value), 1, MAX_MULTIPV); },
+     {}, 1, MAX_MULTIPV},
+    {"PruningDepth", "spin", pruning_default(&Search::pruning_params::max_depth),
+     [](const std::string& value) { pruning.max_depth = std::clamp(std::stoi(value), 0, 8); }, {}, 0, 8},
+    {"ReverseFutilityMargin", "spin", pruning_default(&Search::pruning_params::reverse_futility),
+     [](const std::string& value) { pruning.reverse_futility = std::clamp(std::stoi(value), 0, 1000); }, {}, 0, 1000},
+    {"FutilityMargin", "spin", pruning_default(&Search::pruning_params::futility),
+     [](const std::string& value) { pruning.futility = std::clamp(std::stoi(value), 0, 1000); }, {}, 0, 1000},
+    {"LateMovePruning", "spin", pruning_default(&Search::pruning_params::late_move),
+     [](const std::string& value) { pruning.late_move = std::clamp(std::stoi(value), 0, 64); }, {}, 0, 64},
+};
+
 // uci command -> identify engine with id
-//             -> TODO: set options with option cmd
+//             -> list options with option cmd
 //             -> uciok cmd to verify using uci
 static void uci_cmd()
 {
     std::cout << "id name test_engine\n"
-              << "id author Colin Sweetland\n"
-              << "uciok\n";
+              << "id author Colin Sweetland\n";
+
+    for (const uci_option& opt : options)
+    {
+        std::cout << "option name " << opt.name << " type " << opt.type << " default " << opt.default_value;
+
+        for (const std::string& var : opt.vars)
+            std::cout << " var " << var;
+
+        if (opt.type == "spin")
+            std::cout << " min " << opt.min << " max " << opt.max;
+
+        std::cout << '\n';
+    }
+
+    std::cout << "uciok\n";
+}
+
+// setoption name <id> [value <x>] -> set an engine option, id and value can contain spaces
+static void setoption_cmd(std::vector<std::string>& tokens)
+{
+    std::string name;
+    std::string value;
+
+    size_t i = 1;
+
+    if (i < tokens.size() && tokens[i] == "name")
+        i++;
+
+    for (; i < tokens.size() && tokens[i] != "value"; i++)
+        name += (name.empty() ? "" : " ") + tokens[i];
+
+    // skip 'value' token
+    for (i++; i < tokens.size(); i++)
+        value += (value.empty() ? "" : " ") + tokens[i];
+
+    for (const uci_option& opt : options)
+    {
+        if (opt.name == name)
+        {
+            opt.on_set(value);
+            return;
+        }
+    }
+
+    send_info("unknown option " + name);
 }
 
 const int DEFAULT_SEARCH_DEPTH = 4;
 
-// go -> find best move
+// currmove lines start once the search has run this long, and come at most this often
+constexpr auto CURRMOVE_DELAY    = std::chrono::milliseconds(1000);
+constexpr auto CURRMOVE_INTERVAL = std::chrono::milliseconds(100);
+
+// info line of a finished depth, for one of it's best lines (multipv is only shown with more than one)
+static std::string info_line(const Search::search_info& info, size_t line_num,
+                             std::chrono::steady_clock::duration elapsed)
+{
+    const int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+
+    const Search::pv_line& pv_line = info.lines[line_num];
+
+    std::ostringstream line;
+
+    line << "info depth " << info.depth << " seldepth " << info.seldepth;
+
+    if (info.lines.size() > 1)
+        line << " multipv " << line_num + 1;
+
+    line << " score " << Engine::UCI_score(pv_line.score) << " nodes " << info.nodes_searched << " nps "
+         << info.nodes_searched * 1000 / std::max<int64_t>(ms, 1) << " hashfull " << info.table->hashfull() << " time "
+         << ms << " pv";
+
+    for (const ChessMove& move : pv_line.pv)
+        line << ' ' << move;
+
+    return line.str();
+}
+
+// the search runs on a thread of it's own, so stop (and isready) are read while it searches.
+// it's one long lived thread: the per thread caches (eval, pawns) stay warm from one search to the next
+class search_thread
+{
+  public:
+    search_thread() : m_thread([this] { job_loop(); }) {}
+
+    ~search_thread()
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_quit = true;
+        }
+
+        m_job_ready.notify_one();
+        m_thread.join();
+    }
+
+    // run job on the search thread. the last one must be finished
+    void start(std::function<void()> job)
+    {
+        {
+            std::lock_guard lock{m_mutex};
+            m_job = std::move(job);
+        }
+
+        m_job_ready.notify_one();
+    }
+
+    // wait until the job is done
+    void wait()
+    {
+        std::unique_lock lock{m_mutex};
+        m_job_done.wait(lock, [this] { return !m_job; });
+    }
+
+  private:
+    void job_loop()
+    {
+        std::unique_lock lock{m_mutex};
+
+        for (;;)
+        {
+            m_job_ready.wait(lock, [this] { return m_job || m_quit; });
+
+            if (!m_job)
+                return;
+
+            lock.unlock();
+            m_job();
+            lock.lock();
+
+            m_job = nullptr;
+            m_job_done.notify_all();
+        }
+    }
+
+    std::mutex              m_mutex;
+    std::condition_variable m_job_ready;
+    std::condition_variable m_job_done;
+    std::function<void()>   m_job;
+    bool                    m_quit = false;
+
+    // last, so everything it uses exists when it starts
+    std::thread m_thread;
+};
+
+// started with the first search
+static search_thread& searcher()
+{
+    static search_thread thread;
+    return thread;
+}
+
+// state of the current search, only changed by the uci thread while no search runs (except stop_flag)
+static bool              searching       = false;
+static bool              search_infinite = false;
+static std::atomic<bool> stop_flag{false};
+
+// wait for the search to end. an infinite one only ends with stop, so it's stopped
+static void finish_search(bool stop = false)
+{
+    if (!searching)
+        return;
+
+    if (stop || search_infinite)
+        stop_flag = true;
+
+    searcher().wait();
+    searching = false;
+}
+
+// a go limit: a non negative integer, false if the token isn't one
+static bool parse_go_value(const std::string& token, int64_t& value)
+{
+    if (token.empty() || !std::all_of(token.begin(), token.end(), [](unsigned char c) { return std::isdigit(c); }))
+        return false;
+
+    try
+    {
+        value = std::stoll(token);
+    }
+    catch (const std::exception&)
+    {
+        return false; // out of range
+    }
+
+    return true;
+}
+
+bool Engine::parse_go_limits(const std::vector<std::string>& tokens, int default_depth, Search::search_params& params,
+                             bool& infinite)
+{
+    params.depth = 0;
+    infinite     = false;
+
+    for (size_t i = 1; i < tokens.size(); i++)
+    {
+        const std::string& name = tokens[i];
+        int64_t            value;
+
+        if (name == "infinite")
+        {
+            infinite = true;
+            continue;
+        }
+
+        if (name != "depth" && name != "nodes" && name != "mate" && name != "movetime")
+            continue; // not supported (wtime, btime...)
+
+        if (i + 1 >= tokens.size() || !parse_go_value(tokens[++i], value))
+            return false;
+
+        if (name == "depth")
+            params.depth = static_cast<int>(std::clamp<int64_t>(value, 1, Search::MAX_PLY));
+        else if (name == "nodes")
+            params.nodes = static_cast<uint64_t>(value);
+        else if (name == "mate")
+            params.mate = static_cast<int>(std::min<int64_t>(value, Search::MAX_PLY));
+        else
+            params.movetime = std::max<int64_t>(1, value);
+    }
+
+    if (params.depth == 0)
+    {
+        const bool limited = params.nodes || params.mate || params.movetime || infinite;
+        params.depth       = limited ? Search::MAX_PLY : default_depth;
+    }
+
+    return true;
+}
+
+// go -> find best move, on the search thread
+//    -> depth <plies>, nodes <count>, mate <moves>, movetime <ms>, infinite (until stop)
 static void go_cmd(Position& pos, std::vector<std::string>& tokens)
 {
     // start timer as soon as possible
     const auto start = std::chrono::steady_clock::now();
 
-    int depth = DEFAULT_SEARCH_DEPTH;
+    output_queue& out = output();
+
+    // play from the book without searching, while the position is in it
+    if (own_book)
+    {
+        const ChessMove book_move = Book::probe(pos, book_selection);
+
+        if (book_move.get_moved_piece() != NO_PIECE)
+        {
+            out.send(info_string("book move"));
+            out.send("bestmove " + book_move.to_str());
+            out.flush();
+            return;
+        }
+    }
+
+    Search::search_params params;
+    params.multipv = multipv;
+    params.pruning = pruning;
+    params.stop    = &stop_flag;
+
+    bool infinite;
+
+    if (!Engine::parse_go_limits(tokens, DEFAULT_SEARCH_DEPTH, params, infinite))
+    {
+        send_info("invalid go command");
+        return;
+    }
+
+    stop_flag       = false;
+    search_infinite = infinite;
+    searching       = true;
+
+    searcher().start([&out, search_pos = pos, params, infinite, start]() mutable {
+        auto last_currmove = start;
+
+        const auto on_currmove = [&](ChessMove move, int move_number, int) {
+            const auto now = std::chrono::steady_clock::now();
+
+            if (now - start < CURRMOVE_DELAY || now - last_currmove < CURRMOVE_INTERVAL)
+                return;
+
+            last_currmove = now;
+            out.send("info currmove " + move.to_str() + " currmovenumber " + std::to_string(move_number));
+        };
+
+        const auto on_info = [&](const Search::search_info& info) {
+            const auto elapsed = std::chrono::steady_clock::now() - start;
 
-    // search for 'depth' subcommand (others not supported right now)
-    // stop 1 short of the end because depth command needs an argument
-    for (size_t i = 0; i < tokens.size() - 1; i++)
-        if (tokens[i] == "depth")
-            depth = std::stoi(tokens[++i]);
+            for (size_t line_num = 0; line_num < info.lines.size(); line_num++)
+                out.send(info_line(info, line_num, elapsed));
+        };
 
-    auto info = Search::negamax_root(pos, depth);
+        auto info = Search::negamax_root(search_pos, params, tt::global(), on_info, on_currmove);
 
-    // done search
-    const auto end        = std::chrono::steady_clock::now();
-    const auto searched_s = std::chrono::duration<double>(end - start);
+        // go infinite only sends bestmove after stop, even if the search ended by itself
+        while (infinite && !stop_flag)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
 
-    std::cout << "info depth " << depth << " score cp " << info.score << " time "
-              << static_cast<int>(searched_s.count() * 1000.0) << " nodes " << info.nodes_searched << " nps "
-              << static_cast<int>(info.nodes_searched / searched_s.count()) << "\n";
+        out.send("bestmove " + info.best_move.to_str());
 
-    std::cout << "bestmove " << info.best_move << '\n';
+        // everything is written before the search counts as finished,
+        // so the output of the commands after it (written directly) comes after this
+        out.flush();
+    });
 }
 
-// Create a chessmove on pos with a string representing a move (in format UCI uses)
-static const ChessMove UCI_move(Position& pos, std::string move_string)
+ChessMove Engine::UCI_move(Position& pos, const std::string& move_string)
 {
     const int origin_file = move_string[0] - 'a' + 1;
     const int origin_rank = move_string[1] - '1' + 1;
@@ -103,8 +594,15 @@ static const ChessMove UCI_move(Position& pos, std::string move_string)
     return {moved_p, after_move_p, origin, dest, capture_p};
 }
 
-// position -> set current position
-static void position_cmd(Position& pos, std::vector<std::string>& tokens)
+std::string Engine::UCI_score(centipawn score)
+{
+    if (is_mate_score(score))
+        return "mate " + std::to_string(mate_moves(score));
+
+    return "cp " + std::to_string(score);
+}
+
+bool Engine::parse_position(Position& pos, const std::vector<std::string>& tokens)
 {
     size_t i = 3;
 
@@ -126,25 +624,153 @@ static void position_cmd(Position& pos, std::vector<std::string>& tokens)
             fen += ' ';
         }
 
+        std::string error;
+
+        if (!Position::validate_fen(fen, error))
+            return false;
+
         pos = {fen};
     }
     else if (tokens.size() >= 2 && tokens[1] == "startpos")
         pos = {};
     else
-        return; // ignore invalid input -> noop
+        return false; // ignore invalid input -> noop
 
     // make moves after "moves" token if we have one
     for (; i < tokens.size(); i++)
     {
-        ChessMove uci_m = UCI_move(pos, tokens[i]);
+        const std::string& move_str = tokens[i];
+
+        if (move_str.size() < 4 || move_str[0] < 'a' || move_str[0] > 'h' || move_str[1] < '1' || move_str[1] > '8'
+            || move_str[2] < 'a' || move_str[2] > 'h' || move_str[3] < '1' || move_str[3] > '8')
+            return false;
+
+        const ChessMove uci_m = UCI_move(pos, move_str);
+
+        // the uci move only makes sense if there's a legal move just like it
+        const move_list legal = pos.legal_moves();
+
+        if (std::find(legal.begin(), legal.end(), uci_m) == legal.end())
+            return false;
+
         pos.make_move(uci_m);
     }
 
+    return true;
+}
+
+// position -> set current position
+static void position_cmd(Position& pos, std::vector<std::string>& tokens)
+{
+    if (!Engine::parse_position(pos, tokens))
+        send_info("invalid position command");
+
     // interactive mode feature: auto print the position
     if (interactive)
         std::cout << pos;
 }
 
+static void evalbench(Position& pos, int iterations)
+{
+    const bool nnue_was_enabled = nnue::enabled();
+
+    for (bool use_nnue : {false, true})
+    {
+        nnue::set_enabled(use_nnue);
+
+        // sum evals so the calls can't be optimized away
+        int64_t eval_sum = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < iterations; i++)
+            eval_sum += Engine::compute_static_eval(pos);
+
+        const std::chrono::duration<double> elapsed_sec = std::chrono::steady_clock::now() - start;
+
+        std::cout << (use_nnue ? "NNUE:        " : "Handcrafted: ") << "eval " << eval_sum / iterations << "\t"
+                  << util::pretty_int(static_cast<int64_t>(iterations / elapsed_sec.count())) << " Evals/sec\n";
+    }
+
+    nnue::set_enabled(nnue_was_enabled);
+}
+
+// nnuecheck -> compare the incrementally updated nnue accumulator with one computed from scratch,
+// over a random walk from the current position and back. nnue is only turned on halfway through the walk
+static void nnuecheck(Position& pos, int plies)
+{
+    const bool nnue_was_enabled = nnue::enabled();
+
+    std::mt19937 rng{12345};
+    int          checked    = 0;
+    int          mismatches = 0;
+
+    const auto check = [&]()
+    {
+        nnue::accumulator fresh;
+        nnue::refresh(pos, fresh);
+
+        const nnue::accumulator& acc = pos.nnue_accumulator();
+        checked++;
+        if (!std::equal(&acc.values[0][0], &acc.values[0][0] + 2 * nnue::HIDDEN, &fresh.values[0][0]))
+            mismatches++;
+    };
+
+    nnue::set_enabled(false);
+
+    int made = 0;
+    for (; made < plies; made++)
+    {
+        if (made == plies / 2)
+        {
+            nnue::set_enabled(true);
+            check();
+        }
+
+        const move_list moves = pos.legal_moves();
+        if (moves.empty())
+            break;
+
+        pos.make_move(moves[rng() % moves.size()]);
+        if (nnue::enabled())
+            check();
+    }
+
+    // back to the start, through the moves made while nnue was off
+    nnue::set_enabled(true);
+    for (; made > 0; made--)
+    {
+        pos.unmake_last();
+        check();
+    }
+
+    nnue::set_enabled(nnue_was_enabled);
+
+    if (mismatches == 0)
+        std::cout << "nnue accumulator ok, " << checked << " positions checked\n";
+    else
+        std::cout << "nnue accumulator mismatch in " << mismatches << " of " << checked << " positions\n";
+}
+
+// sliderbench -> perft speed of the current position with every slider backend this build supports
+static void sliderbench(Position& pos, int depth)
+{
+    const SLIDER_BACKEND current = slider_backend();
+
+    for (SLIDER_BACKEND backend : {SLIDER_BACKEND::PEXT, SLIDER_BACKEND::MAGIC})
+    {
+        if (!slider_backend_supported(backend))
+            continue;
+
+        init_slider_tables(backend);
+
+        std::cout << (backend == SLIDER_BACKEND::PEXT ? "PEXT:" : "Magic:");
+        Engine::perft_report(pos, depth);
+    }
+
+    init_slider_tables(current);
+}
+
 const size_t MAX_UCI_INPUT_SIZE = 1024;
 
 void Engine::uci_loop()
@@ -160,7 +786,7 @@ void Engine::uci_loop()
     if (interactive)
         send_info("running interactively");
 
-    // initialize transposition table to empty
+    // allocate an empty transposition table
     tt::init();
 
     for (bool quit = false; !quit;)
@@ -181,19 +807,31 @@ void Engine::uci_loop()
 
         // now parse the commands
 
+        // while searching, only stop and isready are answered right away.
+        // anything else waits for the search to finish (ending an infinite one, or any search on quit)
+        if (cmd_tokens[0] != "stop" && cmd_tokens[0] != "isready")
+            finish_search(cmd_tokens[0] == "quit");
+
         if (cmd_tokens[0] == "uci")
             uci_cmd();
 
         else if (cmd_tokens[0] == "quit")
             quit = true;
 
-        //  sync with GUI
+        //  sync with GUI (after the search's output, if it's running)
         else if (cmd_tokens[0] == "isready")
-            std::cout << "readyok\n";
+        {
+            output().send("readyok");
+
+            if (!searching)
+                output().flush();
+        }
+
+        else if (cmd_tokens[0] == "stop")
+            finish_search(true);
 
-        // setoption name <id> value <x> -> set an engine option (we have none right now)
         else if (cmd_tokens[0] == "setoption")
-            send_info("options not implemented");
+            setoption_cmd(cmd_tokens);
 
         else if (cmd_tokens[0] == "position")
             position_cmd(pos, cmd_tokens);
@@ -201,7 +839,7 @@ void Engine::uci_loop()
         // ucinewgame -> next position command will be a new game
         //            -> reset necessary state (e.g. transposition table)
         else if (cmd_tokens[0] == "ucinewgame")
-            tt::init();
+            reset_tt();
 
         else if (cmd_tokens[0] == "go")
             go_cmd(pos, cmd_tokens);
@@ -214,13 +852,90 @@ void Engine::uci_loop()
             std::cout << pos.FEN() << '\n';
 
         else if (cmd_tokens[0] == "printeval")
+            std::cout << "EVAL: " << Engine::evaluate(pos) << '\n';
+
+        else if (cmd_tokens[0] == "evalbench")
+        {
+            int iterations = cmd_tokens.size() > 1 ? std::stoi(cmd_tokens[1]) : 1000000;
+
+            evalbench(pos, iterations);
+        }
+        else if (cmd_tokens[0] == "nnuecheck")
+        {
+            int plies = cmd_tokens.size() > 1 ? std::stoi(cmd_tokens[1]) : 40;
+
+            nnuecheck(pos, plies);
+        }
+        else if (cmd_tokens[0] == "sliderbench")
+        {
+            int perft_depth = cmd_tokens.size() > 1 ? std::stoi(cmd_tokens[1]) : 5;
+
+            sliderbench(pos, perft_depth);
+        }
+        else if (cmd_tokens[0] == "server")
+        {
+            // server [threads] [log2 of table entries per session]
+            const int threads = cmd_tokens.size() > 1 ? std::stoi(cmd_tokens[1])
+                                                      : std::max(1u, std::thread::hardware_concurrency());
+            const size_t tt_entries = cmd_tokens.size() > 2 ? size_t{1} << std::clamp(std::stoi(cmd_tokens[2]), 10, 26)
+                                                            : Engine::DEFAULT_INSTANCE_TT_ENTRIES;
+
+            Server::run(threads, tt_entries);
+            quit = true;
+        }
+        else if (cmd_tokens[0] == "batch")
+        {
+            // batch <file> [depth] [threads]
+            const int batch_depth   = cmd_tokens.size() > 2 ? std::stoi(cmd_tokens[2]) : DEFAULT_SEARCH_DEPTH;
+            const int batch_threads = cmd_tokens.size() > 3 ? std::stoi(cmd_tokens[3])
+                                                            : std::max(1u, std::thread::hardware_concurrency());
+
+            if (cmd_tokens.size() < 2 || !Batch::run(cmd_tokens[1], batch_depth, batch_threads))
+                send_info("couldn't read batch file");
+        }
+        else if (cmd_tokens[0] == "match")
+        {
+            // match key=value... (see match.hpp)
+            Match::settings settings;
+            std::string     error;
+
+            if (Match::parse_settings({cmd_tokens.begin() + 1, cmd_tokens.end()}, settings, error))
+                Match::run(settings);
+            else
+                send_info(error);
+        }
+        else if (cmd_tokens[0] == "stats")
+        {
+            // stats [json] -> statistics of the last search
+            if (!Stats::enabled)
+                send_info("search statistics aren't compiled in (build with make STATS=1)");
+            else if (cmd_tokens.size() > 1 && cmd_tokens[1] == "json")
+                std::cout << Stats::json(Stats::last()) << '\n';
+            else
+                Stats::print(Stats::last());
+        }
+        else if (cmd_tokens[0] == "bookprobe")
+        {
+            Book::dump(pos);
+        }
+        else if (cmd_tokens[0] == "savett")
+        {
+            if (cmd_tokens.size() < 2 || !tt::save(cmd_tokens[1]))
+                send_info("couldn't save transposition table");
+        }
+        else if (cmd_tokens[0] == "loadtt")
+        {
+            if (cmd_tokens.size() < 2 || !tt::load(cmd_tokens[1]))
+                send_info("couldn't load transposition table, keeping the current one");
+        }
+        else if (cmd_tokens[0] == "savenet")
         {
-            auto psl = pos.pseudo_legal_moves();
-            std::cout << "EVAL: " << Engine::evaluate(pos, psl) << '\n';
+            if (cmd_tokens.size() < 2 || !nnue::save(cmd_tokens[1]))
+                send_info("couldn't save network");
         }
         else if (cmd_tokens[0] == "make")
         {
-            pos.make_move(UCI_move(pos, cmd_tokens[1]));
+            pos.make_move(Engine::UCI_move(pos, cmd_tokens[1]));
             std::cout << pos;
         }
         else if (cmd_tokens[0] == "unmake")
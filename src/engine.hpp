@@ -2,17 +2,41 @@
 #define ENGINE_INCL
 
 #include "chessmove.hpp"
+#include "evaluate.hpp"
 #include "position.hpp"
+#include "search.hpp"
+
+#include <string>
+#include <vector>
 
 namespace Engine
 {
 
+// initialize the global tables (sliders, zobrist keys...). Thread safe, and only the first call does anything
+void init();
+
 // interactive mode alters the engine's behavior in terminal
 // to be more suited for humans rather than chess GUIS
 void set_interactive();
 
 void uci_loop();
 
+// Create a chessmove on pos with a string representing a move (in format UCI uses)
+ChessMove UCI_move(Position& pos, const std::string& move_string);
+
+// a score as UCI shows it: "cp <centipawns>", or "mate <moves>" (negative when the side to move is mated)
+std::string UCI_score(centipawn score);
+
+// set pos from a uci position command: position [startpos | fen <fen>] [moves <moves>...]
+// false if the command or fen is invalid (pos is unchanged), or a move is illegal (pos is left at the last legal move)
+bool parse_position(Position& pos, const std::vector<std::string>& tokens);
+
+// the limits of a uci go command: go [depth <plies>] [nodes <count>] [mate <moves>] [movetime <ms>] [infinite].
+// without a depth, the other limits (or stop) end the search; with no limit at all it's default_depth.
+// false if a limit's value is missing or not a non negative integer
+bool parse_go_limits(const std::vector<std::string>& tokens, int default_depth, Search::search_params& params,
+                     bool& infinite);
+
 } // namespace Engine
 
 #endif // ENGINE_INCL
\ No newline at end of file
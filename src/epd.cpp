@@ -0,0 +1,57 @@
+#include "epd.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <vector>
+
+static bool is_number(const std::string& str)
+{
+    return !str.empty() && std::all_of(str.begin(), str.end(), [](unsigned char c) { return std::isdigit(c); });
+}
+
+bool Epd::parse_line(const std::string& line, std::string& fen, std::string& id)
+{
+    std::istringstream stream{line};
+
+    std::vector<std::string> fields;
+
+    for (std::string field; fields.size() < 6 && stream >> field;)
+        fields.push_back(field);
+
+    if (fields.empty() || fields[0][0] == '#')
+        return false;
+
+    // less than 4 fields isn't a position, it's left as it is for the fen check to say so
+    if (fields.size() < 4)
+    {
+        fen = fields[0];
+
+        for (size_t i = 1; i < fields.size(); i++)
+            fen += ' ' + fields[i];
+    }
+    else
+    {
+        fen = fields[0] + ' ' + fields[1] + ' ' + fields[2] + ' ' + fields[3];
+
+        const bool has_counters = fields.size() == 6 && is_number(fields[4]) && is_number(fields[5]);
+
+        fen += has_counters ? ' ' + fields[4] + ' ' + fields[5] : " 0 1";
+    }
+
+    // id operation: id "some name";
+    id.clear();
+
+    const size_t id_pos = line.find(" id \"");
+
+    if (id_pos != std::string::npos)
+    {
+        const size_t start = id_pos + 5;
+        const size_t end   = line.find('"', start);
+
+        if (end != std::string::npos)
+            id = line.substr(start, end - start);
+    }
+
+    return true;
+}
@@ -0,0 +1,17 @@
+#ifndef EPD_INCL
+#define EPD_INCL
+
+#include <string>
+
+// Lines of position files (batch analysis, match openings): a FEN, or an EPD (a FEN without the move counters, then
+// operations like 'bm e4; id "name";'). Blank lines and lines starting with '#' are comments
+namespace Epd
+{
+
+// false if the line is a comment. Else fen is the line's position, with "0 1" for missing move counters,
+// and id is it's id operation (empty if it has none). The fen isn't checked (see Position::validate_fen)
+bool parse_line(const std::string& line, std::string& fen, std::string& id);
+
+} // namespace Epd
+
+#endif // EPD_INCL
@@ -1,10 +1,17 @@
 #include "evaluate.hpp"
 #include "chessmove.hpp"
+#include "gameinfo.hpp"
+#include "nnue.hpp"
+#include "pawns.hpp"
 #include "position.hpp"
 #include "search.hpp"
 #include "types/bitboard.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+#include <atomic>
 #include <cstdint>
+#include <vector>
 
 using namespace Engine;
 
@@ -128,38 +135,164 @@ centipawn piece_sq_table_eval(Position& pos)
     return eval;
 }
 
-// evaluate RELATIVE TO SIDE TO MOVE
-centipawn Engine::evaluate(Position& pos, move_list& pseudo_legal_moves)
+// passed pawn that can push: it depends on the pieces, so it isn't cached with the pawn structure
+constexpr centipawn FREE_PASSER_BONUS = 10;
+
+static centipawn pawn_structure_eval(Position& pos)
+{
+    const Pawns::entry& pawn_entry = Pawns::probe(pos);
+
+    centipawn eval = pawn_entry.score;
+
+    eval += FREE_PASSER_BONUS * popcnt(gen_shift(pawn_entry.passed[WHITE], push_dir(WHITE)) & ~pos.pieces());
+    eval -= FREE_PASSER_BONUS * popcnt(gen_shift(pawn_entry.passed[BLACK], push_dir(BLACK)) & ~pos.pieces());
+
+    // pawn entry is relative to white
+    return pos.side_to_move() == WHITE ? eval : -eval;
+}
+
+centipawn Engine::piece_sq_score(PIECE p, square sq)
+{
+    // kings aren't scored by the handcrafted eval
+    if (p == KING)
+        return 0;
+
+    // psqt are indexed "upside down", like in piece_sq_table_eval
+    return piece_to_cp_score(p) + piece_sq_tables[p][mirror_vertically(sq)];
+}
+
+// ----- EVAL CACHE -----
+
+struct eval_cache_entry
+{
+    zhash_t   hash  = 0;
+    centipawn eval  = 0;
+    bool      valid = false;
+};
+
+// must be power of 2 size
+static constexpr size_t eval_cache_size       = (1 << 16);
+static constexpr size_t eval_cache_index_mask = eval_cache_size - 1;
+
+// every thread gets its own cache, so it needs no locking
+static thread_local std::vector<eval_cache_entry> eval_cache(eval_cache_size);
+static thread_local Engine::cache_stats           thread_cache_stats;
+
+// bumped when the evaluation function changes. threads clear their cache when they notice
+static std::atomic<uint32_t> eval_gen{0};
+static thread_local uint32_t cache_generation = 0;
+
+const Engine::cache_stats& Engine::eval_cache_stats() { return thread_cache_stats; }
+
+void Engine::reset_eval_cache_stats() { thread_cache_stats = {}; }
+
+void Engine::clear_eval_cache() { eval_gen++; }
+
+uint32_t Engine::eval_generation() { return eval_gen.load(std::memory_order_relaxed); }
+
+centipawn Engine::compute_static_eval(Position& pos)
 {
-    // check for a single legal move: to verify not checkmate or stalemate
-    bool has_legal_move = false;
+    if (nnue::enabled())
+        return nnue::evaluate(pos);
+
+    return piece_value_eval(pos) + piece_sq_table_eval(pos) + pawn_structure_eval(pos);
+}
 
-    for (auto move : pseudo_legal_moves)
+centipawn Engine::static_eval(Position& pos)
+{
+    if (cache_generation != eval_gen.load(std::memory_order_relaxed))
     {
-        if (pos.try_make_move(move))
-        {
-            has_legal_move = true;
-            pos.unmake_last();
-            break;
-        }
+        std::fill(eval_cache.begin(), eval_cache.end(), eval_cache_entry{});
+        cache_generation = eval_gen.load(std::memory_order_relaxed);
     }
 
-    // if we don't have legal moves, it's checkmate or stalemate
-    if (!has_legal_move)
-    {
-        if (pos.is_check())
-            return LOST_EVAL;
+    eval_cache_entry& cached = eval_cache[pos.zhash() & eval_cache_index_mask];
 
-        else
-            return DRAW_EVAL;
+    thread_cache_stats.probes++;
+
+    if (cached.valid && cached.hash == pos.zhash())
+    {
+        thread_cache_stats.hits++;
+        return cached.eval;
     }
 
+    centipawn eval = compute_static_eval(pos);
+
+    cached = {pos.zhash(), eval, true};
+
+    return eval;
+}
+
+Engine::GAME_STATE Engine::game_state(const Position& pos)
+{
+    // if we don't have legal moves, it's checkmate or stalemate
+    if (!pos.has_legal_move())
+        return pos.is_check() ? GAME_STATE::CHECKMATE : GAME_STATE::STALEMATE;
+
     // if we had a legal moves, but it's been 50 reversible full moves, it's a draw
-    else if (pos.has_been_50_reversible_full_moves())
-        return Engine::DRAW_EVAL;
+    if (pos.rev_move_count() >= 100)
+        return GAME_STATE::FIFTY_MOVE_DRAW;
+
+    return GAME_STATE::ONGOING;
+}
+
+centipawn Engine::game_over_eval(GAME_STATE state)
+{
+    assert(state != GAME_STATE::ONGOING);
+    return state == GAME_STATE::CHECKMATE ? LOST_EVAL : DRAW_EVAL;
+}
+
+// evaluate RELATIVE TO SIDE TO MOVE
+centipawn Engine::evaluate(Position& pos)
+{
+    GAME_STATE state = game_state(pos);
+
+    if (state != GAME_STATE::ONGOING)
+        return game_over_eval(state);
+
+    // small endgames are known exactly
+    const Bitbase::RESULT result = Bitbase::probe(pos);
+
+    if (result != Bitbase::RESULT::UNKNOWN)
+        return bitbase_eval(pos, result);
 
     // finally: evaluation for normal positions
-    centipawn eval = piece_value_eval(pos) + piece_sq_table_eval(pos);
+    return static_eval(pos);
+}
 
-    return eval;
+centipawn Engine::bitbase_eval(Position& pos, Bitbase::RESULT result)
+{
+    assert(result != Bitbase::RESULT::UNKNOWN);
+
+    if (result == Bitbase::RESULT::DRAW)
+        return DRAW_EVAL;
+
+    const COLOR strong = result == Bitbase::RESULT::WIN ? pos.side_to_move() : !pos.side_to_move();
+
+    const square strong_king = lsb(pos.pieces(strong, KING));
+    const square weak_king   = lsb(pos.pieces(!strong, KING));
+
+    // static eval from the strong side
+    centipawn eval = KNOWN_WIN_EVAL + (strong == pos.side_to_move() ? 1 : -1) * compute_static_eval(pos);
+
+    const bitboard pawns = pos.pieces(strong, PAWN);
+
+    if (pawns)
+    {
+        // promote: the queen / rook result takes over from there
+        const square psq = lsb(pawns);
+        eval += 20 * (strong == WHITE ? rank_num(psq) : 9 - rank_num(psq));
+    }
+    else
+    {
+        // mate happens on the edge, with the kings close together
+        const int edge_dist = std::min({file_num(weak_king) - 1, 8 - file_num(weak_king), rank_num(weak_king) - 1,
+                                        8 - rank_num(weak_king)});
+        const int king_dist = std::max(std::abs(file_num(strong_king) - file_num(weak_king)),
+                                       std::abs(rank_num(strong_king) - rank_num(weak_king)));
+
+        eval += 20 * (3 - edge_dist) + 10 * (7 - king_dist);
+    }
+
+    return result == Bitbase::RESULT::WIN ? eval : -eval;
 }
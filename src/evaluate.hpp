@@ -2,6 +2,7 @@
 #define EVAL_INCL
 
 #include "./types/pieces.hpp"
+#include "bitbase.hpp"
 #include "chessmove.hpp"
 
 #include <cstdint>
@@ -19,12 +20,30 @@ constexpr centipawn NEGATIVE_INF_EVAL = (INT32_MIN + 5);
 constexpr centipawn POSITIVE_INF_EVAL = (INT32_MAX - 5);
 
 // +/- some because we still need to prefer earlier depth checkmates
-constexpr centipawn LOST_EVAL = NEGATIVE_INF_EVAL + 10000;
 constexpr centipawn WON_EVAL  = POSITIVE_INF_EVAL - 10000;
+constexpr centipawn LOST_EVAL = -WON_EVAL;
+
+// checkmate scores in the search count plies from the root: mating sooner (or being mated later) scores better.
+// no mate is further than this, so scores past +/- MATE_BOUND are mates
+constexpr centipawn MATE_BOUND = WON_EVAL - 1000;
+
+// the side to move mates, ply plies from the root
+constexpr centipawn mate_in(int ply) { return WON_EVAL - ply; }
+
+// the side to move is mated, ply plies from the root
+constexpr centipawn mated_in(int ply) { return LOST_EVAL + ply; }
+
+constexpr bool is_mate_score(centipawn score) { return score >= MATE_BOUND || score <= -MATE_BOUND; }
+
+// moves to the mate of a mate score, as uci counts them: positive if the side to move mates, negative if it's mated
+constexpr int mate_moves(centipawn score) { return score > 0 ? (WON_EVAL - score + 1) / 2 : -(score - LOST_EVAL) / 2; }
 
 // draw is equally bad for both sides
 constexpr centipawn DRAW_EVAL = 0;
 
+// positions known to be won (from the bitbases) score above this, so they're preferred over any material advantage
+constexpr centipawn KNOWN_WIN_EVAL = 10000;
+
 constexpr centipawn piece_to_cp_score(PIECE p)
 {
     //  NONE, PAWN, KNIGHT, BISHOP, ROOK, QUEEN
@@ -39,10 +58,53 @@ constexpr centipawn tempo_bonus(uint8_t depth) { return depth * 5; }
 // likewise: avoid checkmate at earlier depths, even if it's guarunteed: could help draw on time
 constexpr centipawn tempo_penalty(uint8_t depth) { return -tempo_bonus(depth); }
 
-// full evaluation of the position, relative to side moving (needed for negamax search).
-// move_list param helps us to see if position is checkmate
+// material + psqt score of a white piece on sq (mirror sq for black pieces)
+centipawn piece_sq_score(PIECE p, square sq);
+
+// evaluation of the material/position only (no checkmate or draw detection), relative to side moving.
+// results are cached per thread, keyed by the position hash
+centipawn static_eval(Position& pos);
+
+// same as above, skipping the cache (for benchmarking)
+centipawn compute_static_eval(Position& pos);
+
+enum class GAME_STATE
+{
+    ONGOING,
+    CHECKMATE, // side to move is checkmated
+    STALEMATE,
+    FIFTY_MOVE_DRAW
+};
+
+// is the game over? (repetition draws are left to the search, they depend on history)
+GAME_STATE game_state(const Position& pos);
+
+// eval of a finished game, relative to side moving. tempo penalty NOT included
+centipawn game_over_eval(GAME_STATE state);
+
+// full evaluation of the position, relative to side moving: game state, then static eval.
 // tempo bonus/penalty NOT included, must be added if desired
-centipawn evaluate(Position& pos, move_list& pseudo_legal_moves);
+centipawn evaluate(Position& pos);
+
+// eval of a position with a known (bitbase) result, relative to side moving. wins still reward progress
+// (material, cornering the lone king or pushing the pawn) so the search finds the way to checkmate
+centipawn bitbase_eval(Position& pos, Bitbase::RESULT result);
+
+struct cache_stats
+{
+    uint64_t probes = 0;
+    uint64_t hits   = 0;
+};
+
+// stats of the calling thread's eval cache
+const cache_stats& eval_cache_stats();
+void               reset_eval_cache_stats();
+
+// the evaluation function changed: forget all cached evals (in every thread)
+void clear_eval_cache();
+
+// changes whenever clear_eval_cache() is called, so evals stored elsewhere (the transposition tables) can be tagged
+uint32_t eval_generation();
 
 } // namespace Engine
 
@@ -0,0 +1,68 @@
+#include "instance.hpp"
+#include "perft.hpp"
+
+#include <algorithm>
+
+Engine::instance::instance(size_t tt_entries) : m_tt(tt_entries) {}
+
+bool Engine::instance::set_position(const std::vector<std::string>& tokens)
+{
+    return Engine::parse_position(m_pos, tokens);
+}
+
+bool Engine::instance::set_fen(const std::string& fen)
+{
+    std::string error;
+
+    if (!Position::validate_fen(fen, error))
+        return false;
+
+    m_pos = {fen};
+    return true;
+}
+
+bool Engine::instance::make_move(const std::string& uci_move)
+{
+    const move_list legal = m_pos.legal_moves();
+
+    auto it = std::find_if(legal.begin(), legal.end(), [&](const ChessMove& m) { return m.to_str() == uci_move; });
+
+    if (it == legal.end())
+        return false;
+
+    m_pos.make_move(*it);
+    return true;
+}
+
+bool Engine::instance::unmake_move()
+{
+    ChessMove last = m_pos.last_move();
+
+    if (last.is_null())
+        return false;
+
+    m_pos.unmake_last();
+    return true;
+}
+
+uint64_t Engine::instance::perft(int depth) { return Engine::perft(m_pos, depth); }
+
+Search::search_info Engine::instance::search(const Search::search_params& params, const Search::info_callback& on_info)
+{
+    if (params.stop != nullptr)
+        return Search::negamax_root(m_pos, params, m_tt, on_info);
+
+    Search::search_params own_params = params;
+    own_params.stop                  = &m_stop;
+
+    const Search::search_info info = Search::negamax_root(m_pos, own_params, m_tt, on_info);
+
+    // cleared after the search, not before: a stop() that came before the search started still stops it
+    m_stop = false;
+
+    return info;
+}
+
+void Engine::instance::new_game() { m_tt.clear(); }
+
+size_t Engine::instance::memory_bytes() const { return sizeof(*this) + m_tt.size_bytes(); }
@@ -0,0 +1,87 @@
+#ifndef INSTANCE_INCL
+#define INSTANCE_INCL
+
+#include "engine.hpp"
+#include "evaluate.hpp"
+#include "position.hpp"
+#include "search.hpp"
+#include "transposition.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+
+// entries in an instance's own table (~150kb): enough for the low depth searches of many games at once
+constexpr size_t DEFAULT_INSTANCE_TT_ENTRIES = (1 << 12);
+
+// An independent engine: a position, and a transposition table and search state of it's own.
+// Different instances can search at the same time on different threads, but one instance is only
+// used by one thread at a time. The global tables are initialized (Engine::init) by the constructor
+class instance
+{
+  public:
+    explicit instance(size_t tt_entries = DEFAULT_INSTANCE_TT_ENTRIES);
+
+    // uci position command, see Engine::parse_position
+    bool set_position(const std::vector<std::string>& tokens);
+
+    // false (and the position is unchanged) if the fen is invalid, see Position::validate_fen
+    bool set_fen(const std::string& fen);
+
+    Position&       position() { return m_pos; }
+    const Position& position() const { return m_pos; }
+
+    move_list legal_moves() { return m_pos.legal_moves(); }
+
+    // play a move in uci format, false (and nothing happens) if it isn't legal
+    bool make_move(const std::string& uci_move);
+
+    // take back the last move, false if there is none
+    bool unmake_move();
+
+    // full evaluation (game over, then static eval), relative to side moving
+    centipawn evaluate() { return Engine::evaluate(m_pos); }
+
+    uint64_t perft(int depth);
+
+    // on_info is called when each depth is done. The position must have a legal move.
+    // without a stop flag in params, the search can be stopped by stop()
+    Search::search_info search(const Search::search_params& params, const Search::info_callback& on_info = {});
+
+    Search::search_info search(int depth, const Search::info_callback& on_info = {})
+    {
+        return search(Search::search_params{depth}, on_info);
+    }
+
+    // stop the running search (it keeps the result of the last depth it finished), or if none is running,
+    // the next one as soon as it starts. unlike everything else, this can be called from another thread while the instance searches
+    void stop() { m_stop = true; }
+
+    // the next position is from a new game: forget the table
+    void new_game();
+
+    // memory the instance owns (the table as allocated, not all of it is touched)
+    size_t memory_bytes() const;
+
+  private:
+    // first member: the global tables are ready before the position is made
+    struct global_init
+    {
+        global_init() { Engine::init(); }
+    };
+
+    global_init m_init;
+
+    Position  m_pos;
+    tt::table m_tt;
+
+    std::atomic<bool> m_stop = false;
+};
+
+} // namespace Engine
+
+#endif // INSTANCE_INCL
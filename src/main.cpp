@@ -7,15 +7,6 @@
 #include <unistd.h>
 
 #include "engine.hpp"
-#include "movegen.hpp"
-#include "zobrist.hpp"
-
-void init(void)
-{
-    init_rook_table();
-    init_bishop_table();
-    Zobrist::init();
-}
 
 int main(void)
 {
@@ -24,7 +15,7 @@ int main(void)
         Engine::set_interactive();
 
     srand(time(NULL));
-    init();
+    Engine::init();
     Engine::uci_loop();
 
     return 0;
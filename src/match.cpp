@@ -0,0 +1,620 @@
+#include "match.hpp"
+#include "engine.hpp"
+#include "epd.hpp"
+#include "evaluate.hpp"
+#include "position.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+// unix processes and pipes
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace Match;
+
+// ------------------ SETTINGS -----------------------
+
+static std::string this_executable()
+{
+    char    buf[4096];
+    ssize_t len = readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+
+    return len > 0 ? std::string(buf, len) : "";
+}
+
+// limits the engines understand: "<depth|nodes|movetime> <n>" pairs.
+// anything else would be ignored by go, and the engines would play at their default depth
+static bool valid_go_args(const std::string& go_args)
+{
+    std::istringstream tokens{go_args};
+    std::string        limit, value;
+    bool               any = false;
+
+    while (tokens >> limit)
+    {
+        if ((limit != "depth" && limit != "nodes" && limit != "movetime") || !(tokens >> value)
+            || value.find_first_not_of("0123456789") != std::string::npos || std::stoll(value) <= 0)
+            return false;
+
+        any = true;
+    }
+
+    return any;
+}
+
+bool Match::parse_settings(const std::vector<std::string>& tokens, settings& s, std::string& error)
+{
+    s.engines[0].path = s.engines[1].path = this_executable();
+    s.engines[0].name = "engine1";
+    s.engines[1].name = "engine2";
+
+    for (const std::string& token : tokens)
+    {
+        const size_t eq = token.find('=');
+
+        if (eq == std::string::npos)
+        {
+            error = "expected key=value, got " + token;
+            return false;
+        }
+
+        const std::string key   = token.substr(0, eq);
+        const std::string value = token.substr(eq + 1);
+
+        try
+        {
+            if (key == "engine1" || key == "engine2")
+                s.engines[key.back() - '1'].path = value;
+            else if (key == "name1" || key == "name2")
+                s.engines[key.back() - '1'].name = value;
+            else if (key.rfind("option1.", 0) == 0 || key.rfind("option2.", 0) == 0)
+                s.engines[key[6] - '1'].options.emplace_back(key.substr(8), value);
+            else if (key == "tc")
+            {
+                s.go_args = value;
+                std::replace(s.go_args.begin(), s.go_args.end(), '_', ' ');
+
+                if (!valid_go_args(s.go_args))
+                {
+                    error = "tc must be depth, nodes and/or movetime limits (like depth_4 or movetime_100), got "
+                          + value;
+                    return false;
+                }
+            }
+            else if (key == "games")
+                s.games = std::stoi(value);
+            else if (key == "concurrency")
+                s.concurrency = std::max(1, std::stoi(value));
+            else if (key == "maxplies")
+                s.max_plies = std::stoi(value);
+            else if (key == "openings")
+                s.openings_path = value;
+            else if (key == "pgn")
+                s.pgn_path = value;
+            else if (key == "elo0")
+                s.elo0 = std::stod(value);
+            else if (key == "elo1")
+                s.elo1 = std::stod(value);
+            else if (key == "alpha")
+                s.alpha = std::stod(value);
+            else if (key == "beta")
+                s.beta = std::stod(value);
+            else
+            {
+                error = "unknown setting " + key;
+                return false;
+            }
+        }
+        catch (const std::exception&)
+        {
+            error = "bad value for " + key + ": " + value;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// ------------------ UCI PROCESS -----------------------
+
+// an engine running as a child process, talking UCI over pipes
+class uci_process
+{
+  public:
+    ~uci_process() { stop(); }
+
+    bool start(const engine_config& config)
+    {
+        int to_child[2];
+        int from_child[2];
+
+        // close on exec: engines started by other threads mustn't inherit our ends of the pipes
+        if (pipe2(to_child, O_CLOEXEC) != 0 || pipe2(from_child, O_CLOEXEC) != 0)
+            return false;
+
+        m_pid = fork();
+
+        if (m_pid == 0)
+        {
+            dup2(to_child[0], STDIN_FILENO);
+            dup2(from_child[1], STDOUT_FILENO);
+
+            close(to_child[0]);
+            close(to_child[1]);
+            close(from_child[0]);
+            close(from_child[1]);
+
+            execl(config.path.c_str(), config.path.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+
+        close(to_child[0]);
+        close(from_child[1]);
+
+        m_in  = fdopen(to_child[1], "w");
+        m_out = fdopen(from_child[0], "r");
+
+        if (m_pid < 0 || m_in == nullptr || m_out == nullptr)
+            return false;
+
+        send("uci");
+
+        if (!wait_for("uciok"))
+            return false;
+
+        for (const auto& [name, value] : config.options)
+            send("setoption name " + name + " value " + value);
+
+        return ready();
+    }
+
+    void stop()
+    {
+        m_died = false;
+
+        if (m_in != nullptr)
+        {
+            send("quit");
+            fclose(m_in);
+        }
+
+        if (m_out != nullptr)
+            fclose(m_out);
+
+        if (m_pid > 0)
+            waitpid(m_pid, nullptr, 0);
+
+        m_in  = nullptr;
+        m_out = nullptr;
+        m_pid = -1;
+    }
+
+    void send(const std::string& line)
+    {
+        std::fputs((line + '\n').c_str(), m_in);
+        std::fflush(m_in);
+    }
+
+    bool ready()
+    {
+        send("isready");
+        return wait_for("readyok");
+    }
+
+    // the move the engine plays, or an empty string if it died
+    std::string best_move(const std::string& position_cmd, const std::string& go_args)
+    {
+        send(position_cmd);
+        send("go " + go_args);
+
+        std::string line;
+
+        while (read_line(line))
+        {
+            if (line.rfind("bestmove ", 0) == 0)
+            {
+                std::istringstream tokens{line};
+                std::string        bestmove, move;
+
+                tokens >> bestmove >> move;
+                return move;
+            }
+        }
+
+        m_died = true;
+        return "";
+    }
+
+    // the engine closed it's output (crashed or quit), it has to be restarted to play on
+    bool died() const { return m_died; }
+
+  private:
+    bool read_line(std::string& line)
+    {
+        char*  buf  = nullptr;
+        size_t size = 0;
+
+        const ssize_t len = getline(&buf, &size, m_out);
+
+        if (len > 0)
+            line.assign(buf, buf[len - 1] == '\n' ? len - 1 : len);
+
+        std::free(buf);
+        return len > 0;
+    }
+
+    bool wait_for(const std::string& token)
+    {
+        for (std::string line; read_line(line);)
+            if (line.rfind(token, 0) == 0)
+                return true;
+
+        return false;
+    }
+
+    pid_t m_pid  = -1;
+    FILE* m_in   = nullptr;
+    FILE* m_out  = nullptr;
+    bool  m_died = false;
+};
+
+// ------------------ GAMES -----------------------
+
+// standard algebraic notation, for the PGN
+static std::string san(Position& pos, ChessMove move)
+{
+    std::string str;
+
+    if (move.is_castle())
+        str = file_num(move.get_dest()) == 7 ? "O-O" : "O-O-O";
+
+    else if (move.get_moved_piece() == PAWN)
+    {
+        if (move.is_capture())
+            str = {file_char(move.get_orig()), 'x'};
+
+        str += sq_str(move.get_dest());
+
+        if (move.is_promo())
+            str += {'=', static_cast<char>(std::toupper(piece_to_char(move.get_promo_piece())))};
+    }
+    else
+    {
+        str = static_cast<char>(std::toupper(piece_to_char(move.get_moved_piece())));
+
+        // other pieces of the same type that can go to the same square
+        bool ambiguous = false, same_file = false, same_rank = false;
+
+        for (ChessMove other : pos.legal_moves())
+        {
+            if (other.get_moved_piece() != move.get_moved_piece() || other.get_dest() != move.get_dest()
+                || other.get_orig() == move.get_orig())
+                continue;
+
+            ambiguous = true;
+            same_file |= file_num(other.get_orig()) == file_num(move.get_orig());
+            same_rank |= rank_num(other.get_orig()) == rank_num(move.get_orig());
+        }
+
+        if (ambiguous && (!same_file || same_rank))
+            str += file_char(move.get_orig());
+        if (ambiguous && same_file)
+            str += rank_char(move.get_orig());
+
+        if (move.is_capture())
+            str += 'x';
+
+        str += sq_str(move.get_dest());
+    }
+
+    pos.make_move(move);
+
+    if (pos.is_check())
+        str += pos.has_legal_move() ? '+' : '#';
+
+    pos.unmake_last();
+
+    return str;
+}
+
+// neither side can ever checkmate: bare kings, or a single minor piece
+static bool insufficient_material(const Position& pos)
+{
+    const bitboard heavy = pos.pieces(PAWN) | pos.pieces(ROOK) | pos.pieces(QUEEN);
+
+    return !heavy && popcnt(pos.pieces(KNIGHT) | pos.pieces(BISHOP)) <= 1;
+}
+
+struct game_result
+{
+    // from white's point of view: 1, 0.5, 0
+    double      white_score;
+    std::string reason;
+    std::string movetext;
+};
+
+static game_result play_game(uci_process* players[2], const std::string& fen, const settings& s)
+{
+    Position pos{fen};
+
+    std::string moves;
+    std::string movetext;
+
+    for (uci_process* p : {players[WHITE], players[BLACK]})
+    {
+        p->send("ucinewgame");
+        p->ready();
+    }
+
+    for (int ply = 0; ply < s.max_plies; ply++)
+    {
+        const Engine::GAME_STATE state = Engine::game_state(pos);
+        const COLOR              stm   = pos.side_to_move();
+
+        if (state == Engine::GAME_STATE::CHECKMATE)
+            return {stm == WHITE ? 0.0 : 1.0, "checkmate", movetext};
+        if (state == Engine::GAME_STATE::STALEMATE)
+            return {0.5, "stalemate", movetext};
+        if (state == Engine::GAME_STATE::FIFTY_MOVE_DRAW)
+            return {0.5, "fifty move rule", movetext};
+        if (pos.is_repetition())
+            return {0.5, "threefold repetition", movetext};
+        if (insufficient_material(pos))
+            return {0.5, "insufficient material", movetext};
+
+        const std::string move_str = players[stm]->best_move("position fen " + fen + moves, s.go_args);
+
+        const move_list legal = pos.legal_moves();
+
+        auto it = std::find_if(legal.begin(), legal.end(), [&](const ChessMove& m) { return m.to_str() == move_str; });
+
+        // the engine crashed, or played an illegal move: it loses
+        if (players[stm]->died())
+            return {stm == WHITE ? 0.0 : 1.0, "engine crashed", movetext};
+
+        if (it == legal.end())
+            return {stm == WHITE ? 0.0 : 1.0, "illegal move " + move_str, movetext};
+
+        if (stm == WHITE || movetext.empty())
+            movetext += std::to_string(pos.full_move_count()) + (stm == WHITE ? ". " : "... ");
+
+        movetext += san(pos, *it) + ' ';
+        moves += (moves.empty() ? " moves " : " ") + move_str;
+
+        pos.make_move(*it);
+    }
+
+    return {0.5, "adjudicated after " + std::to_string(s.max_plies) + " plies", movetext};
+}
+
+static std::string result_str(double white_score)
+{
+    return white_score == 1.0 ? "1-0" : white_score == 0.0 ? "0-1" : "1/2-1/2";
+}
+
+static std::string pgn(const settings& s, int round, const std::string& fen, const std::string& white,
+                       const std::string& black, const game_result& result)
+{
+    char      date[16];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y.%m.%d", std::localtime(&now));
+
+    std::ostringstream out;
+
+    out << "[Event \"self-play match\"]\n"
+        << "[Site \"?\"]\n"
+        << "[Date \"" << date << "\"]\n"
+        << "[Round \"" << round << "\"]\n"
+        << "[White \"" << white << "\"]\n"
+        << "[Black \"" << black << "\"]\n"
+        << "[Result \"" << result_str(result.white_score) << "\"]\n";
+
+    if (fen != Position{}.FEN())
+        out << "[SetUp \"1\"]\n[FEN \"" << fen << "\"]\n";
+
+    out << "[TimeControl \"" << s.go_args << "\"]\n"
+        << "[Termination \"" << result.reason << "\"]\n\n"
+        << result.movetext << result_str(result.white_score) << "\n\n";
+
+    return out.str();
+}
+
+// ------------------ STATISTICS -----------------------
+
+// expected score of the stronger side
+static double elo_to_score(double elo) { return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0)); }
+
+static double score_to_elo(double score) { return -400.0 * std::log10(1.0 / score - 1.0); }
+
+// generalized SPRT log likelihood ratio, with the normal approximation of the (trinomial) score distribution
+static double sprt_llr(int wins, int draws, int losses, double elo0, double elo1)
+{
+    const double n = wins + draws + losses;
+
+    if (n == 0)
+        return 0.0;
+
+    const double mean = (wins + draws * 0.5) / n;
+    const double var  = (wins * std::pow(1.0 - mean, 2) + draws * std::pow(0.5 - mean, 2) + losses * std::pow(mean, 2)) / n;
+
+    // all results the same: no information about the spread yet
+    if (var <= 0)
+        return 0.0;
+
+    const double s0 = elo_to_score(elo0);
+    const double s1 = elo_to_score(elo1);
+
+    return (s1 - s0) * (2 * mean - s0 - s1) * n / (2 * var);
+}
+
+struct match_state
+{
+    std::mutex mutex;
+
+    std::atomic<int>  next_game{0};
+    std::atomic<bool> stop{false};
+
+    // from engine 1's point of view
+    int wins = 0, draws = 0, losses = 0;
+
+    std::ofstream pgn_file;
+};
+
+static void play_games(const settings& s, const std::vector<std::string>& openings, match_state& state)
+{
+    uci_process engines[2];
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (!engines[i].start(s.engines[i]))
+        {
+            std::lock_guard<std::mutex> lock{state.mutex};
+            std::cout << "couldn't start " << s.engines[i].path << '\n';
+            state.stop = true;
+            return;
+        }
+    }
+
+    const double llr_lower = std::log(s.beta / (1 - s.alpha));
+    const double llr_upper = std::log((1 - s.beta) / s.alpha);
+
+    for (int game = state.next_game++; game < s.games && !state.stop; game = state.next_game++)
+    {
+        // every opening twice, engine 1 is white in the first game
+        const std::string& fen           = openings[(game / 2) % openings.size()];
+        const bool         engine1_white = game % 2 == 0;
+
+        uci_process* players[2] = {&engines[!engine1_white], &engines[engine1_white]};
+
+        const game_result result = play_game(players, fen, s);
+
+        const double engine1_score = engine1_white ? result.white_score : 1.0 - result.white_score;
+
+        std::lock_guard<std::mutex> lock{state.mutex};
+
+        state.wins += engine1_score == 1.0;
+        state.draws += engine1_score == 0.5;
+        state.losses += engine1_score == 0.0;
+
+        const int    played = state.wins + state.draws + state.losses;
+        const double score  = (state.wins + 0.5 * state.draws) / played;
+        const double llr    = sprt_llr(state.wins, state.draws, state.losses, s.elo0, s.elo1);
+
+        const std::string& white = s.engines[engine1_white ? 0 : 1].name;
+        const std::string& black = s.engines[engine1_white ? 1 : 0].name;
+
+        std::cout << "game " << game + 1 << ": " << white << " - " << black << " " << result_str(result.white_score) << " ("
+                  << result.reason << ")  +" << state.wins << " =" << state.draws << " -" << state.losses << "  score "
+                  << std::fixed << std::setprecision(3) << score << "  llr " << std::setprecision(2) << llr << " ["
+                  << llr_lower << ", " << llr_upper << "]\n";
+
+        if (state.pgn_file.is_open())
+            state.pgn_file << pgn(s, game + 1, fen, white, black, result) << std::flush;
+
+        if (llr >= llr_upper || llr <= llr_lower)
+            state.stop = true;
+
+        // a crashed engine would lose every game left: start it again, or end the match
+        for (int i = 0; i < 2; i++)
+        {
+            if (!engines[i].died())
+                continue;
+
+            engines[i].stop();
+
+            if (!engines[i].start(s.engines[i]))
+            {
+                std::cout << s.engines[i].name << " crashed and couldn't be restarted, stopping the match\n";
+                state.stop = true;
+                return;
+            }
+
+            std::cout << s.engines[i].name << " crashed, restarted it\n";
+        }
+    }
+}
+
+void Match::run(const settings& s)
+{
+    // a dead engine shouldn't take us down with it when we write to it
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<std::string> openings;
+
+    if (!s.openings_path.empty())
+    {
+        std::ifstream file{s.openings_path};
+
+        std::string fen, id, error;
+        int         line_num = 0;
+
+        for (std::string line; std::getline(file, line);)
+        {
+            line_num++;
+
+            if (!Epd::parse_line(line, fen, id))
+                continue;
+
+            if (Position::validate_fen(fen, error))
+                openings.push_back(fen);
+            else
+                std::cout << "skipping opening on line " << line_num << ": " << error << '\n';
+        }
+    }
+
+    if (openings.empty())
+        openings.push_back(Position{}.FEN());
+
+    match_state state;
+
+    if (!s.pgn_path.empty())
+        state.pgn_file.open(s.pgn_path, std::ios::app);
+
+    std::vector<std::thread> workers;
+
+    for (int i = 0; i < s.concurrency; i++)
+        workers.emplace_back(play_games, std::cref(s), std::cref(openings), std::ref(state));
+
+    for (std::thread& t : workers)
+        t.join();
+
+    const int played = state.wins + state.draws + state.losses;
+
+    if (played == 0)
+        return;
+
+    const double llr       = sprt_llr(state.wins, state.draws, state.losses, s.elo0, s.elo1);
+    const double llr_upper = std::log((1 - s.beta) / s.alpha);
+    const double llr_lower = std::log(s.beta / (1 - s.alpha));
+
+    // elo of engine 1, with a 95% interval from the standard error of the score
+    const double score = (state.wins + 0.5 * state.draws) / played;
+    const double var   = (state.wins * std::pow(1.0 - score, 2) + state.draws * std::pow(0.5 - score, 2)
+                        + state.losses * std::pow(score, 2))
+                     / played;
+    const double margin = 1.96 * std::sqrt(var / played);
+
+    const auto elo = [](double sc) { return score_to_elo(std::clamp(sc, 0.001, 0.999)); };
+
+    std::cout << "\n" << s.engines[0].name << " vs " << s.engines[1].name << ": " << played << " games, +" << state.wins
+              << " =" << state.draws << " -" << state.losses << '\n'
+              << "elo " << std::fixed << std::setprecision(1) << elo(score) << " [" << elo(score - margin) << ", "
+              << elo(score + margin) << "]\n"
+              << "sprt (elo0 " << s.elo0 << ", elo1 " << s.elo1 << "): llr " << std::setprecision(2) << llr << ", "
+              << (llr >= llr_upper   ? "H1 accepted"
+                  : llr <= llr_lower ? "H0 accepted"
+                                     : "inconclusive")
+              << '\n';
+}
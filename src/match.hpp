@@ -0,0 +1,52 @@
+#ifndef MATCH_INCL
+#define MATCH_INCL
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Self-play matches: two engine configurations play each other, to check a change doesn't cost strength.
+// Engines are separate UCI processes (this binary by default), so a configuration can be another build,
+// or the same build with different UCI options. Every opening is played twice, with colors swapped.
+// The match stops early when the SPRT (elo0 vs elo1) accepts either hypothesis
+namespace Match
+{
+
+struct engine_config
+{
+    std::string                                      name;
+    std::string                                      path;
+    std::vector<std::pair<std::string, std::string>> options; // setoption name/value
+};
+
+struct settings
+{
+    engine_config engines[2];
+
+    std::string go_args     = "depth 4"; // sent with every go: depth, nodes and movetime limits ("movetime 100")
+    int         games       = 100;
+    int         concurrency = 1;
+    int         max_plies   = 400; // adjudicated as a draw after this many plies
+
+    std::string openings_path; // EPD/FEN file, the starting position if empty
+    std::string pgn_path;      // games are appended as PGN, if not empty
+
+    // SPRT: is engine 1 elo1 stronger (H1) or elo0 (H0)?
+    double elo0  = 0.0;
+    double elo1  = 5.0;
+    double alpha = 0.05;
+    double beta  = 0.05;
+};
+
+// settings from "key=value" tokens:
+//   engine1=<path> engine2=<path> name1=<name> name2=<name> option1.<Name>=<value> option2.<Name>=<value>
+//   tc=<go limits, '_' for spaces> games=<n> concurrency=<n> maxplies=<n> openings=<file> pgn=<file>
+//   elo0=<elo> elo1=<elo> alpha=<p> beta=<p>
+// false (with error set) on an unknown key or bad value
+bool parse_settings(const std::vector<std::string>& tokens, settings& s, std::string& error);
+
+void run(const settings& s);
+
+} // namespace Match
+
+#endif // MATCH_INCL
@@ -1,8 +1,7 @@
-// need for PEXT/PDEP
 #include <array>
 #include <cassert>
 #include <cstddef>
-#include <x86intrin.h>
+#include <mutex>
 
 #include "./types/bitboard.hpp"
 #include "chessmove.hpp"
@@ -11,20 +10,59 @@
 #include "position.hpp"
 #include "types/pieces.hpp"
 
+// cpu detection, and the PEXT instruction
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 // when we shift east/west, wrapping can happen. To avoid this, we have to mask a row
 static constexpr bitboard e_mask = ~BB_FILE_A;
 static constexpr bitboard w_mask = ~BB_FILE_H;
 
+// squares between lookup [sq1][sq2], generated at compile time by walking the 8 directions from every square
+static constexpr std::array<std::array<bitboard, 64>, 64> make_between_table()
+{
+    std::array<std::array<bitboard, 64>, 64> table{};
+
+    constexpr int rank_step[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+    constexpr int file_step[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+    for (int sq = 0; sq < 64; sq++)
+    {
+        for (int dir = 0; dir < 8; dir++)
+        {
+            bitboard between = BB_ZERO;
+
+            int rank = sq / 8 + rank_step[dir];
+            int file = sq % 8 + file_step[dir];
+
+            while (rank >= 0 && rank < 8 && file >= 0 && file < 8)
+            {
+                table[sq][rank * 8 + file] = between;
+                between |= 1ULL << (rank * 8 + file);
+
+                rank += rank_step[dir];
+                file += file_step[dir];
+            }
+        }
+    }
+
+    return table;
+}
+
+static constexpr std::array<std::array<bitboard, 64>, 64> BETWEEN_LOOKUP = make_between_table();
+
+bitboard bb_between(square sq1, square sq2) { return BETWEEN_LOOKUP[sq1][sq2]; }
+
 // create a check mask : limits squares we can generate moves to when in check.
 // the king never uses this to generate it's moves, but all other pieces do.
 bitboard create_check_mask(const Position& pos)
 {
     bitboard checkers_bb = pos.get_checkers_bb();
-    bitboard occ         = pos.pieces();
     square   kng_sq      = lsb(pos.pieces(pos.side_to_move(), KING));
     square   checker_sq  = lsb(checkers_bb);
     bitboard check_mask  = checkers_bb;
-    COLOR    enemy       = !pos.side_to_move();
 
     // not check: regular pseudolegal move generation to any square (full check mask)
     if (!checkers_bb)
@@ -34,21 +72,10 @@ bitboard create_check_mask(const Position& pos)
     else if (checkers_bb & (checkers_bb - 1))
         check_mask &= BB_ZERO;
 
-    // single rook or bishop or queen : we must capture it, or block it or move king to a safe square
-    // we can rule out all squares that aren't along the direction they attack each other
-    // however, their are some false positives with this method.
-    // TODO: create a "squares between" lookup table. only 64x64 = 4096 entries
-    else if (checkers_bb & pos.pieces(enemy, ROOK))
-        check_mask |= bb_rook_moves(kng_sq, occ) & bb_rook_moves(checker_sq, occ);
-
-    else if (checkers_bb & pos.pieces(enemy, BISHOP))
-        check_mask |= bb_bishop_moves(kng_sq, occ) & bb_bishop_moves(checker_sq, occ);
-
-    else if (checkers_bb & pos.pieces(enemy, QUEEN))
-        check_mask |= bb_queen_moves(kng_sq, occ) & bb_queen_moves(checker_sq, occ);
-
-    // else there would be a single pawn or knight attacker, but since these aren't sliders, we must capture them or
-    // move king, so it's exactly the same as checkers_bb
+    // single attacker: we must capture it, or block it (only possible for sliders) or move king to a safe square.
+    // for pawns and knights there is nothing between them and the king
+    else
+        check_mask |= bb_between(kng_sq, checker_sq);
 
     return check_mask;
 }
@@ -109,10 +136,16 @@ void generate_moves<PAWN>(const Position& pos, move_list& ml, [[maybe_unused]] c
     if (pos.en_passante_sq() != -1)
         attackable |= bb_from_sq(pos.en_passante_sq());
 
+    // en passante can capture a checking pawn without landing on it's square
+    bitboard attack_mask = check_mask;
+
+    if (pos.en_passante_sq() != -1 && bb_is_set_at_sq(check_mask, pos.en_passante_sq() - pushd))
+        attack_mask |= bb_from_sq(pos.en_passante_sq());
+
     bitboard single_push = bb_pawn_single_moves(pawns, pos.pieces(), friendly);
     bitboard double_push = bb_pawn_double_moves(single_push, pos.pieces(), friendly) & check_mask;
-    bitboard p_att_e     = bb_pawn_attacks_e(pawns, attackable, friendly) & check_mask;
-    bitboard p_att_w     = bb_pawn_attacks_w(pawns, attackable, friendly) & check_mask;
+    bitboard p_att_e     = bb_pawn_attacks_e(pawns, attackable, friendly) & attack_mask;
+    bitboard p_att_w     = bb_pawn_attacks_w(pawns, attackable, friendly) & attack_mask;
     single_push &= check_mask;
 
     // double pawn pushes -> can never be capture or promotion
@@ -292,6 +325,165 @@ move_list Position::legal_moves()
     return legal;
 }
 
+// every piece (of both colors) attacking sq, with the given occupancy for sliders
+bitboard Position::attackers_to(square sq, bitboard occ) const
+{
+    const bitboard sq_bb = bb_from_sq(sq);
+
+    // a white pawn attacks sq if a black pawn on sq would attack it, and vice versa
+    bitboard attackers = bb_pawn_attacks_e(sq_bb, pieces(WHITE, PAWN), BLACK);
+    attackers |= bb_pawn_attacks_w(sq_bb, pieces(WHITE, PAWN), BLACK);
+    attackers |= bb_pawn_attacks_e(sq_bb, pieces(BLACK, PAWN), WHITE);
+    attackers |= bb_pawn_attacks_w(sq_bb, pieces(BLACK, PAWN), WHITE);
+
+    attackers |= bb_knight_moves(sq) & pieces(KNIGHT);
+    attackers |= bb_king_moves(sq) & pieces(KING);
+    attackers |= bb_rook_moves(sq, occ) & (pieces(ROOK) | pieces(QUEEN));
+    attackers |= bb_bishop_moves(sq, occ) & (pieces(BISHOP) | pieces(QUEEN));
+
+    return attackers;
+}
+
+// pawn pushes and captures (not en passante) for the pawns, on the side to move
+static bitboard pawn_targets(const Position& pos, bitboard pawns)
+{
+    const COLOR friendly = pos.side_to_move();
+
+    bitboard single_push = bb_pawn_single_moves(pawns, pos.pieces(), friendly);
+    bitboard targets     = single_push | bb_pawn_double_moves(single_push, pos.pieces(), friendly);
+
+    targets |= bb_pawn_attacks_e(pawns, pos.pieces(!friendly), friendly);
+    targets |= bb_pawn_attacks_w(pawns, pos.pieces(!friendly), friendly);
+
+    return targets;
+}
+
+// Does the side to move have any legal move? Only used to detect checkmate and stalemate,
+// so it works with the check mask and pins instead of generating moves and making them.
+// Castling is never checked: if castling is legal, moving the king one square towards the rook is too.
+bool Position::has_legal_move() const
+{
+    const COLOR    enemy  = !m_stm;
+    const bitboard own    = pieces(m_stm);
+    const bitboard occ    = pieces();
+    const bitboard kng_bb = pieces(m_stm, KING);
+    const square   kng_sq = lsb(kng_bb);
+
+    // --- KING ---
+    // remove the king from the occupancy, so it can't hide behind itself from a slider
+    bitboard kng_moves = bb_king_moves(kng_sq) & ~own;
+
+    while (kng_moves)
+    {
+        if (!(attackers_to(pop_lsb(kng_moves), occ ^ kng_bb) & pieces(enemy)))
+            return true;
+    }
+
+    const bitboard check_mask = create_check_mask(*this);
+
+    // double check: only the king could have moved
+    if (check_mask == BB_ZERO)
+        return false;
+
+    // --- PINNED PIECES ---
+    // enemy sliders which would attack our king if our pieces weren't there
+    bitboard snipers = bb_rook_moves(kng_sq, pieces(enemy)) & (pieces(enemy, ROOK) | pieces(enemy, QUEEN));
+    snipers |= bb_bishop_moves(kng_sq, pieces(enemy)) & (pieces(enemy, BISHOP) | pieces(enemy, QUEEN));
+
+    bitboard pinned = BB_ZERO;
+
+    while (snipers)
+    {
+        const square   sniper_sq = pop_lsb(snipers);
+        const bitboard pin_line  = bb_between(kng_sq, sniper_sq);
+        const bitboard blockers  = pin_line & occ;
+
+        // pinned: exactly one piece in the way, and it's ours
+        if (!(blockers & own) || (blockers & (blockers - 1)))
+            continue;
+
+        pinned |= blockers;
+
+        // a pinned piece can still move along the pin (and capture the pinner)
+        const square   pinned_sq = lsb(blockers);
+        const bitboard allowed   = (pin_line | bb_from_sq(sniper_sq)) & check_mask & ~own;
+
+        bitboard targets = BB_ZERO;
+
+        switch (piece_at_sq(pinned_sq))
+        {
+        case PAWN:
+            targets = pawn_targets(*this, blockers);
+            break;
+        case BISHOP:
+            targets = bb_bishop_moves(pinned_sq, occ);
+            break;
+        case ROOK:
+            targets = bb_rook_moves(pinned_sq, occ);
+            break;
+        case QUEEN:
+            targets = bb_queen_moves(pinned_sq, occ);
+            break;
+        // a pinned knight can never move
+        default:
+            break;
+        }
+
+        if (targets & allowed)
+            return true;
+    }
+
+    // --- OTHER PIECES ---
+
+    if (pawn_targets(*this, pieces(m_stm, PAWN) & ~pinned) & check_mask)
+        return true;
+
+    const bitboard moveable = ~own & check_mask;
+
+    bitboard knights = pieces(m_stm, KNIGHT) & ~pinned;
+    while (knights)
+        if (moves_bb<KNIGHT>(pop_lsb(knights), occ) & moveable)
+            return true;
+
+    bitboard bishops = pieces(m_stm, BISHOP) & ~pinned;
+    while (bishops)
+        if (moves_bb<BISHOP>(pop_lsb(bishops), occ) & moveable)
+            return true;
+
+    bitboard rooks = pieces(m_stm, ROOK) & ~pinned;
+    while (rooks)
+        if (moves_bb<ROOK>(pop_lsb(rooks), occ) & moveable)
+            return true;
+
+    bitboard queens = pieces(m_stm, QUEEN) & ~pinned;
+    while (queens)
+        if (moves_bb<QUEEN>(pop_lsb(queens), occ) & moveable)
+            return true;
+
+    // --- EN PASSANTE ---
+    // it removes 2 pieces from a rank, so check the king directly instead of with pins
+    if (is_valid(m_enp_sq))
+    {
+        const square   cap_sq = m_enp_sq - push_dir(m_stm);
+        const bitboard enp_bb = bb_from_sq(m_enp_sq);
+        const bitboard cap_bb = bb_from_sq(cap_sq);
+
+        // our pawns that attack the en passante square
+        bitboard capturers = bb_pawn_attacks_e(enp_bb, pieces(m_stm, PAWN), enemy);
+        capturers |= bb_pawn_attacks_w(enp_bb, pieces(m_stm, PAWN), enemy);
+
+        while (capturers)
+        {
+            const bitboard after_occ = (occ ^ bb_from_sq(pop_lsb(capturers)) ^ cap_bb) | enp_bb;
+
+            if (!(attackers_to(kng_sq, after_occ) & pieces(enemy) & ~cap_bb))
+                return true;
+        }
+    }
+
+    return false;
+}
+
 // Adapted from chessprogramming wiki
 // used for generating bishop and rook tables
 static bitboard dumb7fill(square origin_sq, bitboard blockers, DIR* dirs)
@@ -348,12 +540,96 @@ static bitboard dumb7fill(square origin_sq, bitboard blockers, DIR* dirs)
     return moves_bb;
 }
 
-// ------------------ BISHOPS -----------------------
+// ------------------ SLIDER TABLES -----------------------
+
+// Each slider has one flat table, holding the moves for every blocker combination of every square.
+// There are two ways to turn the blockers into an index inside a square's part of the table:
+//  PEXT:  the BMI2 instruction packs the blocker bits together. Fastest, when the cpu has a fast pext
+//  MAGIC: multiply the blockers by a magic number, the top bits of the product are a perfect hash
+//         ("fancy" magic bitboards). Works everywhere, and is close behind
+// Both use 2^popcnt(mask) entries per square, so the layout is the same, only the order within a square differs.
+//
+// PEXT is only compiled into builds for a cpu with BMI2 (-march=x86-64-v3 and up, or native on such a cpu), where
+// the instruction inlines. Other builds always use MAGIC, and the lookups don't look at the backend at all.
+//
+// Each backend has it's own tables. The backend is a plain variable read by every lookup, so it must only be
+// switched while no search (or anything else generating moves) runs
+static SLIDER_BACKEND backend = SLIDER_BACKEND::MAGIC;
+
+// the backend lookups use
+static inline SLIDER_BACKEND active_backend()
+{
+#if defined(__BMI2__)
+    return backend;
+#else
+    return SLIDER_BACKEND::MAGIC;
+#endif
+}
+
+constexpr int BACKEND_COUNT = 2;
+
+static bool       tables_built[BACKEND_COUNT] = {};
+static std::mutex init_mutex;
+
+struct slider_square
+{
+    bitboard mask;   // squares that can hold blockers
+    bitboard magic;  // magic multiplier
+    uint32_t offset; // where this square's moves start in the table
+    uint32_t shift;  // 64 - bits in the index
+};
+
+// the offset of square 64 is the size of the whole table
+static constexpr std::array<slider_square, 65> make_slider_squares(const std::array<const bitboard, 64>& masks,
+                                                                   const std::array<const bitboard, 64>& magics)
+{
+    std::array<slider_square, 65> squares{};
+
+    for (square sq = 0; sq < 64; sq++)
+    {
+        squares[sq].mask       = masks[sq];
+        squares[sq].magic      = magics[sq];
+        squares[sq].shift      = 64 - popcnt(masks[sq]);
+        squares[sq + 1].offset = squares[sq].offset + (1U << popcnt(masks[sq]));
+    }
+
+    return squares;
+}
+
+// index of the blocker combination, within the square's part of the table
+static inline uint32_t slider_index(bitboard blockers, const slider_square& s, [[maybe_unused]] SLIDER_BACKEND b)
+{
+#if defined(__BMI2__)
+    if (b == SLIDER_BACKEND::PEXT)
+        return _pext_u64(blockers, s.mask);
+#endif
+
+    return ((blockers & s.mask) * s.magic) >> s.shift;
+}
+
+// fill in the moves for every blocker combination of every square, indexed for backend b.
+// The carry rippler trick visits every subset of the mask
+static void init_slider_table(bitboard* table, const std::array<slider_square, 65>& squares, DIR* dirs,
+                              SLIDER_BACKEND b)
+{
+    for (square curr_sq = 0; curr_sq < 64; curr_sq++)
+    {
+        const slider_square& s = squares[curr_sq];
 
-// lookup moves [idxlookup[sq] + PEXT(blockers)]
-// we can make this more memory eff later (many elements are copies of eachother)
-// size: ~41kb (8 bytes (bitboard) * 5185 entries)
-std::array<std::vector<bitboard>, 64> BISHOP_MOVE_LOOKUP = {{}};
+        bitboard blockers = BB_ZERO;
+
+        do
+        {
+            const uint32_t idx = slider_index(blockers, s, b);
+            assert(s.offset + idx < squares[curr_sq + 1].offset);
+
+            table[s.offset + idx] = dumb7fill(curr_sq, blockers, dirs);
+            blockers              = (blockers - s.mask) & s.mask;
+        } while (blockers);
+    }
+}
+
+// ------------------ BISHOPS -----------------------
 
 // squares set might contain pieces that block bishop moves
 static constexpr std::array<const bitboard, 64> BISHOP_BLOCKER_MASK = {
@@ -371,50 +647,38 @@ static constexpr std::array<const bitboard, 64> BISHOP_BLOCKER_MASK = {
     0x0000402010080400, 0x0002040810204000, 0x0004081020400000, 0x000a102040000000, 0x0014224000000000,
     0x0028440200000000, 0x0050080402000000, 0x0020100804020000, 0x0040201008040200};
 
-const bitboard& bb_bishop_moves(square sq, const bitboard& blockers)
-{
-    bitboard blocker_key = pext(blockers, BISHOP_BLOCKER_MASK[sq]);
-    return BISHOP_MOVE_LOOKUP.at(sq).at(blocker_key);
-}
+// found by trial and error: random sparse numbers until one maps every blocker combination without collisions
+static constexpr std::array<const bitboard, 64> BISHOP_MAGIC = {
+    0x10102002004a1420, 0x8020040400584008, 0x10510800811201c8, 0x5204042080000088, 0x2204106880000002,
+    0x1401042004000000, 0x0400880410042004, 0x0028208200a02020, 0x1500241990010e00, 0x8001200182020a40,
+    0x40004101030b0000, 0x8002041042000100, 0x4010011041020038, 0x0000010421044000, 0x1500210808020a00,
+    0x8000088400880520, 0x0405004010040100, 0x1005823210040108, 0x2708008102040011, 0x4048200404009100,
+    0x0018104101400024, 0x0003000601190101, 0x8004803108491000, 0x8014241200820800, 0x0006e080100c3040,
+    0x0501044a11041800, 0x9020300008004045, 0x0894080000220040, 0x1001010083104000, 0x5004030040900080,
+    0x000400422c012400, 0x0002128698404812, 0x1010108404900440, 0x0928021182084100, 0x2006080409020024,
+    0x1010202020180080, 0xa010008200202200, 0x2098015100019004, 0x0002041440810811, 0x802a02020000b098,
+    0x0009015090004060, 0x4000821082081001, 0x0100210040420800, 0x0800004010488a00, 0x2000081104004040,
+    0x4c8e029015000082, 0x0420340322224842, 0x1298260043400210, 0x0000822802400008, 0x00008a0101600000,
+    0x3040003412080021, 0x3040290220884800, 0x4a1500401041004a, 0x8010200282020781, 0x0020203142209091,
+    0x0070300600902110, 0x0040808800b62048, 0x0000810400c44420, 0x00080400440c0441, 0x8340080020840411,
+    0x0000000104208200, 0x0000800810d00080, 0x0400530411080200, 0x4040702400932244};
+
+static constexpr std::array<slider_square, 65> BISHOP_SQUARES = make_slider_squares(BISHOP_BLOCKER_MASK, BISHOP_MAGIC);
+
+// size: ~41kb (8 bytes (bitboard) * 5248 entries)
+alignas(64) static bitboard BISHOP_MOVE_LOOKUP[BACKEND_COUNT][BISHOP_SQUARES[64].offset];
 
-void init_bishop_table(void)
+const bitboard& bb_bishop_moves(square sq, const bitboard& blockers)
 {
-    DIR dirs[4] = {NORTHEAST, SOUTHEAST, NORTHWEST, SOUTHWEST};
-    // iterate over each square
-    for (square curr_sq = 0; curr_sq < 64; curr_sq++)
-    {
-        // blockers can appear in any bit set here
-        bitboard potential_blocker_mask = BISHOP_BLOCKER_MASK[curr_sq];
-
-        // we can have as many blockers as bits set
-        int max_blockers = popcnt(potential_blocker_mask);
-
-        // iterate through all combo of blockers in all relevant positions
-        for (bitboard blockers = BB_ZERO; blockers < bb_from_sq(max_blockers); blockers++)
-        {
-            // this particular combo
-            bitboard blocker_set = pdep(blockers, potential_blocker_mask);
-
-            bitboard moves = dumb7fill(curr_sq, blocker_set, dirs);
-
-            // const cast because we want to be able to write to it now,
-            // but never again
-            BISHOP_MOVE_LOOKUP.at(curr_sq).push_back(moves);
-        }
-
-        BISHOP_MOVE_LOOKUP.at(curr_sq).shrink_to_fit();
-    }
+    const SLIDER_BACKEND b = active_backend();
+    const slider_square& s = BISHOP_SQUARES[sq];
+    return BISHOP_MOVE_LOOKUP[static_cast<int>(b)][s.offset + slider_index(blockers, s, b)];
 }
 
 // ------------------ ROOKS -----------------------
 
-// lookup moves [idxlookup[sq] + PEXT(blockers)]
-// we can make this more memory eff later (many elements are copies of eachother)
-// size: ~800kb (8 bytes (bitboard) * 102337 entries)
-std::array<std::vector<bitboard>, 64> ROOK_MOVE_LOOKUP = {{}};
-
 // squares set might contain pieces that block rook moves
-constexpr std::array<const bitboard, 64> ROOK_BLOCKER_MASK = {
+static constexpr std::array<const bitboard, 64> ROOK_BLOCKER_MASK = {
     0x000101010101017e, 0x000202020202027c, 0x000404040404047a, 0x0008080808080876, 0x001010101010106e,
     0x002020202020205e, 0x004040404040403e, 0x008080808080807e, 0x0001010101017e00, 0x0002020202027c00,
     0x0004040404047a00, 0x0008080808087600, 0x0010101010106e00, 0x0020202020205e00, 0x0040404040403e00,
@@ -429,50 +693,98 @@ constexpr std::array<const bitboard, 64> ROOK_BLOCKER_MASK = {
     0x007e808080808000, 0x7e01010101010100, 0x7c02020202020200, 0x7a04040404040400, 0x7608080808080800,
     0x6e10101010101000, 0x5e20202020202000, 0x3e40404040404000, 0x7e80808080808000};
 
-// Where you can begin to lookup the move bb for a certain square
-// for example, in a1 we have 4095 (2^12 - 1) possible blocker combos,
-// because there are 12 squares where blockers can be
-// so for a2 we start at index 4095 (4096th element)
-// max idx = 102336
-// constexpr std::array<const uint32_t, 64> ROOK_MOVE_START_IDX = {
-//     0,     4095,  6142,  8189,  10236, 12283, 14330, 16377, 20472, 22519, 23542, 24565, 25588, 26611, 27634, 28657,
-//     30704, 32751, 33774, 34797, 35820, 36843, 37866, 38889, 40936, 42983, 44006, 45029, 46052, 47075, 48098, 49121,
-//     51168, 53215, 54238, 55261, 56284, 57307, 58330, 59353, 61400, 63447, 64470, 65493, 66516, 67539, 68562, 69585,
-//     71632, 73679, 74702, 75725, 76748, 77771, 78794, 79817, 81864, 85959, 88006, 90053, 92100, 94147, 96194, 98241};
+static constexpr std::array<const bitboard, 64> ROOK_MAGIC = {
+    0x1080004008801020, 0x0840092002c03000, 0x1900200010400900, 0x0880100008000480, 0x4200100420080200,
+    0x8100020100080400, 0x0200040110886200, 0x0200008040220411, 0x0404800084400220, 0x0000401000402000,
+    0x0086001081220440, 0x0408800800100280, 0x000a001201040820, 0x8848800200840080, 0x4001000100040200,
+    0x0442000102105084, 0x9080010020804100, 0x0040404000201009, 0x0000808010002009, 0x2200090021d00100,
+    0x0008008008040080, 0x0004004002010040, 0x0011040008015042, 0x00000a0001768104, 0x0000800080204009,
+    0x2010004140002001, 0x9800200280100080, 0x1000100080080080, 0x0442000a00049020, 0x2100040080020080,
+    0x0800120400900148, 0x0010040a00128541, 0x2800804000800030, 0x1010002000400041, 0x4000200011004100,
+    0x0610008410800800, 0x0400802402800800, 0xc100020080800400, 0x0002000802000401, 0x0182085882000401,
+    0x0220204000808000, 0x2860100040024022, 0x0001002004110040, 0x99101042000a0020, 0x0004080004008080,
+    0x0010040002008080, 0x2012004881020004, 0x8300842444820011, 0x0088403882010200, 0x0820400080210100,
+    0x0110910040a00300, 0x0801100280080480, 0x0242009008200600, 0x1002000489500200, 0x0040800200010080,
+    0x0091800041000080, 0x0000209300488001, 0x04c1002414824001, 0x020020000b001041, 0x7000100004200901,
+    0x8002002004100802, 0x30010002084c0007, 0x0888221800813004, 0x4000002840840112};
+
+static constexpr std::array<slider_square, 65> ROOK_SQUARES = make_slider_squares(ROOK_BLOCKER_MASK, ROOK_MAGIC);
+
+// size: ~800kb (8 bytes (bitboard) * 102400 entries)
+alignas(64) static bitboard ROOK_MOVE_LOOKUP[BACKEND_COUNT][ROOK_SQUARES[64].offset];
 
 const bitboard& bb_rook_moves(square sq, const bitboard& blockers)
 {
-    bitboard blocker_key = pext(blockers, ROOK_BLOCKER_MASK[sq]);
-    return ROOK_MOVE_LOOKUP.at(sq).at(blocker_key);
+    const SLIDER_BACKEND b = active_backend();
+    const slider_square& s = ROOK_SQUARES[sq];
+    return ROOK_MOVE_LOOKUP[static_cast<int>(b)][s.offset + slider_index(blockers, s, b)];
 }
 
-void init_rook_table(void)
+// ------------------ SLIDER BACKEND -----------------------
+
+bool slider_backend_supported(SLIDER_BACKEND b)
 {
-    DIR dirs[4] = {NORTH, SOUTH, EAST, WEST};
-    // iterate over each square
-    for (square curr_sq = 0; curr_sq < 64; curr_sq++)
-    {
-        // blockers can appear in any bit set here
-        bitboard potential_blocker_mask = ROOK_BLOCKER_MASK[curr_sq];
+    if (b == SLIDER_BACKEND::MAGIC)
+        return true;
+
+#if defined(__BMI2__)
+    // a BMI2 build only runs on a cpu that has it
+    return true;
+#else
+    return false;
+#endif
+}
 
-        // we can have as many blockers as bits set
-        int max_blockers = popcnt(potential_blocker_mask);
+SLIDER_BACKEND best_slider_backend()
+{
+    if (!slider_backend_supported(SLIDER_BACKEND::PEXT))
+        return SLIDER_BACKEND::MAGIC;
 
-        // iterate through all combo of blockers in all relevant positions
-        for (bitboard blockers = BB_ZERO; blockers < bb_from_sq(max_blockers); blockers++)
-        {
-            // this particular combo
-            bitboard blocker_set = pdep(blockers, potential_blocker_mask);
+#if defined(__x86_64__)
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
 
-            bitboard moves = dumb7fill(curr_sq, blocker_set, dirs);
+    // vendor string is in ebx, edx, ecx
+    __get_cpuid(0, &eax, &ebx, &ecx, &edx);
+    const bool amd   = ebx == 0x68747541 && edx == 0x69746e65 && ecx == 0x444d4163; // "AuthenticAMD"
+    const bool hygon = ebx == 0x6f677948 && edx == 0x6e65476e && ecx == 0x656e6975; // "HygonGenuine"
 
-            ROOK_MOVE_LOOKUP.at(curr_sq).push_back(moves);
-        }
+    __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+    const unsigned base_family = (eax >> 8) & 0xf;
+    const unsigned family      = base_family == 0xf ? base_family + ((eax >> 20) & 0xff) : base_family;
 
-        ROOK_MOVE_LOOKUP.at(curr_sq).shrink_to_fit();
+    // AMD before zen 3 (family 19h) runs pext in microcode, taking hundreds of cycles.
+    // Hygon's cpus (family 18h) are zen 1 under another name
+    if ((amd && family < 0x19) || hygon)
+        return SLIDER_BACKEND::MAGIC;
+#endif
+
+    return SLIDER_BACKEND::PEXT;
+}
+
+void init_slider_tables(SLIDER_BACKEND b)
+{
+    assert(slider_backend_supported(b));
+
+    std::lock_guard<std::mutex> lock{init_mutex};
+
+    const int set = static_cast<int>(b);
+
+    if (!tables_built[set])
+    {
+        DIR bishop_dirs[4] = {NORTHEAST, SOUTHEAST, NORTHWEST, SOUTHWEST};
+        init_slider_table(BISHOP_MOVE_LOOKUP[set], BISHOP_SQUARES, bishop_dirs, b);
+
+        DIR rook_dirs[4] = {NORTH, SOUTH, EAST, WEST};
+        init_slider_table(ROOK_MOVE_LOOKUP[set], ROOK_SQUARES, rook_dirs, b);
+
+        tables_built[set] = true;
     }
+
+    backend = b;
 }
 
+SLIDER_BACKEND slider_backend() { return active_backend(); }
+
 // ------------------QUEENS----------------------
 
 bitboard bb_queen_moves(square sq, const bitboard& blockers)
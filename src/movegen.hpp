@@ -12,14 +12,31 @@ enum COLOR : int;
 
 std::ostream& operator<<(std::ostream& out, const ChessMove& move);
 
-// ----- BISHOP MOVES-----
-void init_bishop_table(void);
+// ----- SLIDER TABLES -----
+
+// how bishop and rook lookups index their tables
+enum class SLIDER_BACKEND
+{
+    PEXT, // BMI2 instruction
+    MAGIC // magic multiplication, works on any cpu
+};
+
+// PEXT needs a build for a cpu with BMI2 (see the Makefile's ISA)
+bool slider_backend_supported(SLIDER_BACKEND backend);
+
+// fastest backend on this cpu: pext, unless it's missing or slow
+SLIDER_BACKEND best_slider_backend();
+
+// build bishop and rook tables for backend. Can be called again to switch backends,
+// but only while no other thread generates moves (no search is running)
+void init_slider_tables(SLIDER_BACKEND backend);
 
+SLIDER_BACKEND slider_backend();
+
+// ----- BISHOP MOVES-----
 const bitboard& bb_bishop_moves(square sq, const bitboard& blockers);
 
 // ----- ROOK MOVES-----
-void init_rook_table(void);
-
 const bitboard& bb_rook_moves(square sq, const bitboard& blockers);
 
 // ----- QUEEN MOVES -----
@@ -42,6 +59,9 @@ bitboard bb_pawn_single_moves(const bitboard& pawns, const bitboard& blockers, C
 
 bitboard bb_pawn_double_moves(const bitboard& single_moves, const bitboard& blockers, COLOR side_to_move);
 
+// squares strictly between two squares on the same rank, file or diagonal (empty if they aren't aligned)
+bitboard bb_between(square sq1, square sq2);
+
 bitboard create_check_mask(const Position& pos);
 
 #endif // MOVEGEN_INCL
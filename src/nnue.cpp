@@ -0,0 +1,280 @@
+#include "nnue.hpp"
+#include "./types/bitboard.hpp"
+#include "evaluate.hpp"
+#include "position.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <fstream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace nnue;
+
+struct network
+{
+    alignas(32) int16_t feature_weights[INPUTS][HIDDEN];
+    alignas(32) int16_t feature_bias[HIDDEN];
+
+    // first HIDDEN weights are for the side to move, the rest for the other side
+    alignas(32) int16_t output_weights[2 * HIDDEN];
+
+    // scaled by QA * QB
+    int32_t output_bias;
+};
+
+static network net;
+
+static bool nnue_enabled = false;
+
+static std::atomic<uint32_t> net_generation{1};
+
+// every network file starts with this
+struct file_header
+{
+    char     magic[4] = {'C', 'S', 'N', 'N'};
+    uint32_t version  = 1;
+    uint32_t inputs   = INPUTS;
+    uint32_t hidden   = HIDDEN;
+};
+
+void nnue::set_enabled(bool on)
+{
+    if (on && !nnue_enabled)
+        net_generation++;
+
+    nnue_enabled = on;
+}
+
+bool nnue::enabled() { return nnue_enabled; }
+
+uint32_t nnue::generation() { return net_generation; }
+
+// features are relative to the perspective: "our" pieces come first, and the board is flipped for black
+static inline int feature_index(COLOR perspective, COLOR c, PIECE p, square sq)
+{
+    const square rel_sq = perspective == BLACK ? mirror_vertically(sq) : sq;
+    return ((c != perspective) * 6 + (p - 1)) * 64 + rel_sq;
+}
+
+// The embedded default network is built from the handcrafted material + psqt evaluation.
+// Each piece type owns a group of neurons, and our piece adds its score spread evenly over the group
+// (so a neuron only clips with an unusual amount of one piece type). The output layer then adds our
+// groups and subtracts theirs, which is exactly what the handcrafted eval does.
+void nnue::init()
+{
+    //                                 NONE PAWN KNIGHT BISHOP ROOK QUEEN KING
+    constexpr int group_size[KING + 1] = {0, 8, 8, 8, 16, 24, 0};
+
+    std::memset(&net, 0, sizeof(net));
+
+    int group_start = 0;
+
+    for (int p = PAWN; p <= KING; p++)
+    {
+        const int n = group_size[p];
+
+        for (square sq = 0; sq < 64; sq++)
+        {
+            // our piece, as if we are white
+            const Engine::centipawn score = Engine::piece_sq_score(static_cast<PIECE>(p), sq);
+
+            // total accumulator units for this piece, rounded to nearest
+            const int units = (score * QA + EVAL_SCALE / 2) / EVAL_SCALE;
+            assert(units >= 0);
+
+            int16_t* weights = net.feature_weights[feature_index(WHITE, WHITE, static_cast<PIECE>(p), sq)];
+
+            for (int i = 0; i < n; i++)
+                weights[group_start + i] = units / n + (i < units % n);
+        }
+
+        group_start += n;
+    }
+
+    assert(group_start == HIDDEN);
+
+    for (int i = 0; i < HIDDEN; i++)
+    {
+        net.output_weights[i]          = QB;
+        net.output_weights[HIDDEN + i] = -QB;
+    }
+
+    net_generation++;
+}
+
+bool nnue::load(const std::string& path)
+{
+    std::ifstream file{path, std::ios::binary};
+
+    if (!file)
+        return false;
+
+    file_header expected{};
+    file_header header{};
+
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!file || std::memcmp(&header, &expected, sizeof(header)) != 0)
+        return false;
+
+    // read into a temporary, so a truncated file doesn't leave us with half a network
+    static network loaded;
+
+    file.read(reinterpret_cast<char*>(loaded.feature_weights), sizeof(loaded.feature_weights));
+    file.read(reinterpret_cast<char*>(loaded.feature_bias), sizeof(loaded.feature_bias));
+    file.read(reinterpret_cast<char*>(loaded.output_weights), sizeof(loaded.output_weights));
+    file.read(reinterpret_cast<char*>(&loaded.output_bias), sizeof(loaded.output_bias));
+
+    // must have read everything, and there shouldn't be anything left
+    if (!file || file.peek() != std::ifstream::traits_type::eof())
+        return false;
+
+    net = loaded;
+    net_generation++;
+    return true;
+}
+
+bool nnue::save(const std::string& path)
+{
+    std::ofstream file{path, std::ios::binary};
+
+    file_header header{};
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(net.feature_weights), sizeof(net.feature_weights));
+    file.write(reinterpret_cast<const char*>(net.feature_bias), sizeof(net.feature_bias));
+    file.write(reinterpret_cast<const char*>(net.output_weights), sizeof(net.output_weights));
+    file.write(reinterpret_cast<const char*>(&net.output_bias), sizeof(net.output_bias));
+
+    return static_cast<bool>(file);
+}
+
+// ---------------- KERNELS -----------------
+
+#if defined(__AVX2__)
+
+static_assert(HIDDEN % 16 == 0, "AVX2 kernels work on 16 int16 at a time");
+
+static inline void vec_add(int16_t* acc, const int16_t* weights)
+{
+    for (int i = 0; i < HIDDEN; i += 16)
+    {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i w = _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_add_epi16(a, w));
+    }
+}
+
+static inline void vec_sub(int16_t* acc, const int16_t* weights)
+{
+    for (int i = 0; i < HIDDEN; i += 16)
+    {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i w = _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_sub_epi16(a, w));
+    }
+}
+
+// sum of clamp(in, 0, QA) * weights
+static inline int32_t crelu_dot(const int16_t* in, const int16_t* weights)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i qa   = _mm256_set1_epi16(QA);
+
+    __m256i sum = _mm256_setzero_si256();
+
+    for (int i = 0; i < HIDDEN; i += 16)
+    {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i w = _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i));
+
+        v = _mm256_min_epi16(_mm256_max_epi16(v, zero), qa);
+
+        // multiply to 32 bits and add adjacent pairs (QA * INT16_MAX * 2 fits)
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(v, w));
+    }
+
+    // horizontal add of the 8 lanes
+    __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    sum128         = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum128         = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtsi128_si32(sum128);
+}
+
+#else // scalar fallback
+
+static inline void vec_add(int16_t* acc, const int16_t* weights)
+{
+    for (int i = 0; i < HIDDEN; i++)
+        acc[i] += weights[i];
+}
+
+static inline void vec_sub(int16_t* acc, const int16_t* weights)
+{
+    for (int i = 0; i < HIDDEN; i++)
+        acc[i] -= weights[i];
+}
+
+static inline int32_t crelu_dot(const int16_t* in, const int16_t* weights)
+{
+    int32_t sum = 0;
+
+    for (int i = 0; i < HIDDEN; i++)
+    {
+        const int32_t v = in[i] < 0 ? 0 : (in[i] > QA ? QA : in[i]);
+        sum += v * weights[i];
+    }
+
+    return sum;
+}
+
+#endif
+
+// ----------------- ACCUMULATOR -------------------
+
+void nnue::add_piece(accumulator& acc, COLOR c, PIECE p, square sq)
+{
+    vec_add(acc.values[WHITE], net.feature_weights[feature_index(WHITE, c, p, sq)]);
+    vec_add(acc.values[BLACK], net.feature_weights[feature_index(BLACK, c, p, sq)]);
+}
+
+void nnue::remove_piece(accumulator& acc, COLOR c, PIECE p, square sq)
+{
+    vec_sub(acc.values[WHITE], net.feature_weights[feature_index(WHITE, c, p, sq)]);
+    vec_sub(acc.values[BLACK], net.feature_weights[feature_index(BLACK, c, p, sq)]);
+}
+
+void nnue::refresh(const Position& pos, accumulator& acc)
+{
+    std::memcpy(acc.values[WHITE], net.feature_bias, sizeof(net.feature_bias));
+    std::memcpy(acc.values[BLACK], net.feature_bias, sizeof(net.feature_bias));
+
+    for (COLOR c : {WHITE, BLACK})
+    {
+        for (int p = PAWN; p <= KING; p++)
+        {
+            bitboard p_bb = pos.pieces(c, static_cast<PIECE>(p));
+
+            while (p_bb)
+                add_piece(acc, c, static_cast<PIECE>(p), pop_lsb(p_bb));
+        }
+    }
+
+    acc.generation = generation();
+}
+
+Engine::centipawn nnue::evaluate(Position& pos)
+{
+    const accumulator& acc = pos.nnue_accumulator();
+    const COLOR        stm = pos.side_to_move();
+
+    int64_t output = crelu_dot(acc.values[stm], net.output_weights);
+    output += crelu_dot(acc.values[!stm], net.output_weights + HIDDEN);
+    output += net.output_bias;
+
+    return static_cast<Engine::centipawn>(output * EVAL_SCALE / (QA * QB));
+}
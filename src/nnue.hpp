@@ -0,0 +1,70 @@
+#ifndef NNUE_INCL
+#define NNUE_INCL
+
+#include "./types/bitboard.hpp"
+#include "./types/pieces.hpp"
+#include "evaluate.hpp"
+
+#include <cstdint>
+#include <string>
+
+class Position;
+
+// Efficiently updatable neural network evaluation.
+// The network is (768 -> HIDDEN) x 2 perspectives -> 1, the first layer output (the accumulator)
+// is kept up to date by the position as pieces are placed and removed.
+namespace nnue
+{
+
+// 2 colors * 6 pieces * 64 squares, relative to the perspective
+constexpr int INPUTS = 768;
+constexpr int HIDDEN = 64;
+
+// quantization: first layer weights are scaled by QA, output weights by QB
+constexpr int QA = 255;
+constexpr int QB = 64;
+
+// a network output of 1.0 is this many centipawns
+constexpr int EVAL_SCALE = 400;
+
+// first layer output for both perspectives (index with COLOR)
+struct accumulator
+{
+    alignas(32) int16_t values[2][HIDDEN];
+
+    // network generation the values were computed with (0: never computed).
+    // values from another generation have to be recomputed from the position before they are used
+    uint32_t generation = 0;
+};
+
+// changes whenever the network does (and when nnue is turned on: positions don't update accumulators while it's off)
+uint32_t generation();
+
+// are the accumulator's values from the current network?
+inline bool up_to_date(const accumulator& acc) { return acc.generation == generation(); }
+
+// load the embedded default network
+void init();
+
+// load network from file. On failure the current network is kept and false is returned
+bool load(const std::string& path);
+
+// write the current network to file, in the same format load() reads
+bool save(const std::string& path);
+
+void set_enabled(bool on);
+bool enabled();
+
+// compute accumulator from scratch
+void refresh(const Position& pos, accumulator& acc);
+
+// incremental accumulator updates
+void add_piece(accumulator& acc, COLOR c, PIECE p, square sq);
+void remove_piece(accumulator& acc, COLOR c, PIECE p, square sq);
+
+// evaluate relative to side to move
+Engine::centipawn evaluate(Position& pos);
+
+} // namespace nnue
+
+#endif // NNUE_INCL
@@ -0,0 +1,130 @@
+#include "pawns.hpp"
+#include "./types/bitboard.hpp"
+#include "gameinfo.hpp"
+#include "movegen.hpp"
+#include "position.hpp"
+
+#include <vector>
+
+using Engine::centipawn;
+
+// must be power of 2 size
+static constexpr size_t pawn_table_size       = (1 << 14);
+static constexpr size_t pawn_table_index_mask = pawn_table_size - 1;
+
+// every thread gets its own table, so probing needs no locking
+static thread_local std::vector<Pawns::entry> pawn_table(pawn_table_size);
+static thread_local Pawns::table_stats        pawn_table_stats;
+
+constexpr centipawn DOUBLED_PENALTY  = 10;
+constexpr centipawn ISOLATED_PENALTY = 15;
+constexpr centipawn BACKWARD_PENALTY = 8;
+
+// index with rank number, relative to the pawn's color
+constexpr centipawn PASSED_BONUS[9] = {0, 0, 5, 10, 20, 35, 60, 100, 0};
+
+// ----- PAWN SPANS -----
+
+// every set bit is smeared towards rank 8 / rank 1
+static constexpr bitboard north_fill(bitboard bb)
+{
+    bb |= bb << 8;
+    bb |= bb << 16;
+    bb |= bb << 32;
+    return bb;
+}
+
+static constexpr bitboard south_fill(bitboard bb)
+{
+    bb |= bb >> 8;
+    bb |= bb >> 16;
+    bb |= bb >> 32;
+    return bb;
+}
+
+// smear towards the rank color c promotes on
+static constexpr bitboard front_fill(bitboard bb, COLOR c) { return c == WHITE ? north_fill(bb) : south_fill(bb); }
+
+static constexpr bitboard file_fill(bitboard bb) { return north_fill(bb) | south_fill(bb); }
+
+// the files to the left and right of the set files
+static constexpr bitboard adjacent_files(bitboard files)
+{
+    return ((files << 1) & ~BB_FILE_A) | ((files >> 1) & ~BB_FILE_H);
+}
+
+// every square attacked by pawns of color c
+static bitboard pawn_attacks(bitboard pawns, COLOR c)
+{
+    return bb_pawn_attacks_e(pawns, ~BB_ZERO, c) | bb_pawn_attacks_w(pawns, ~BB_ZERO, c);
+}
+
+// evaluate pawn structure for color c (positive is good for c), and find it's passed pawns
+static centipawn eval_pawns(const Position& pos, COLOR c, bitboard& passed)
+{
+    const bitboard own   = pos.pieces(c, PAWN);
+    const bitboard enemy = pos.pieces(!c, PAWN);
+
+    const DIR pushd = push_dir(c);
+
+    // pawns with a friendly pawn in front of them
+    const bitboard doubled = own & front_fill(gen_shift(own, -pushd), !c);
+
+    // pawns without friendly pawns on adjacent files
+    const bitboard isolated = own & ~adjacent_files(file_fill(own));
+
+    // squares enemy pawns can block or capture on, as they advance
+    const bitboard enemy_front_span  = front_fill(gen_shift(enemy, -pushd), !c);
+    const bitboard enemy_attack_span = front_fill(pawn_attacks(enemy, !c), !c);
+
+    // no enemy pawn can stop them (only the frontmost of doubled pawns counts)
+    passed = own & ~(enemy_front_span | enemy_attack_span) & ~doubled;
+
+    // squares our pawns can defend, now or after advancing
+    const bitboard own_attack_span = front_fill(pawn_attacks(own, c), c);
+
+    // the square in front is attacked by an enemy pawn, and no friendly pawn can ever defend it
+    const bitboard backward =
+        own & gen_shift(gen_shift(own, pushd) & pawn_attacks(enemy, !c) & ~own_attack_span, -pushd) & ~isolated;
+
+    centipawn eval = 0;
+
+    eval -= DOUBLED_PENALTY * popcnt(doubled);
+    eval -= ISOLATED_PENALTY * popcnt(isolated);
+    eval -= BACKWARD_PENALTY * popcnt(backward);
+
+    bitboard passed_bb = passed;
+
+    while (passed_bb)
+    {
+        square sq = pop_lsb(passed_bb);
+
+        eval += PASSED_BONUS[c == WHITE ? rank_num(sq) : 9 - rank_num(sq)];
+    }
+
+    return eval;
+}
+
+const Pawns::entry& Pawns::probe(const Position& pos)
+{
+    entry& e = pawn_table[pos.pawn_zhash() & pawn_table_index_mask];
+
+    pawn_table_stats.probes++;
+
+    if (e.valid && e.pawn_hash == pos.pawn_zhash())
+    {
+        pawn_table_stats.hits++;
+        return e;
+    }
+
+    // miss: evaluate and replace whatever was here
+    e.pawn_hash = pos.pawn_zhash();
+    e.valid     = true;
+    e.score     = eval_pawns(pos, WHITE, e.passed[WHITE]) - eval_pawns(pos, BLACK, e.passed[BLACK]);
+
+    return e;
+}
+
+const Pawns::table_stats& Pawns::stats() { return pawn_table_stats; }
+
+void Pawns::reset_stats() { pawn_table_stats = {}; }
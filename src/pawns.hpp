@@ -0,0 +1,44 @@
+#ifndef PAWNS_INCL
+#define PAWNS_INCL
+
+#include "./types/bitboard.hpp"
+#include "evaluate.hpp"
+#include "zobrist.hpp"
+
+#include <cstdint>
+
+class Position;
+
+// pawn structure evaluation, cached in a (per thread) pawn hash table.
+// pawn structure repeats across most of the search tree, so most probes are hits
+namespace Pawns
+{
+
+struct entry
+{
+    zhash_t pawn_hash = 0;
+    bool    valid     = false;
+
+    // doubled, isolated, backward and passed pawn terms, positive is good for white
+    Engine::centipawn score = 0;
+
+    // index with COLOR
+    bitboard passed[2] = {BB_ZERO, BB_ZERO};
+};
+
+struct table_stats
+{
+    uint64_t probes = 0;
+    uint64_t hits   = 0;
+};
+
+// get the pawn entry for the position, evaluating the pawns if they aren't in the table
+const entry& probe(const Position& pos);
+
+// stats of the calling thread's table
+const table_stats& stats();
+void               reset_stats();
+
+} // namespace Pawns
+
+#endif // PAWNS_INCL
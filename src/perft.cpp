@@ -34,6 +34,17 @@ static void perft(Position& pos, int depth, std::vector<std::uint64_t>& perft_re
     }
 }
 
+uint64_t Engine::perft(Position& pos, int depth)
+{
+    assert(depth >= 0);
+
+    std::vector<std::uint64_t> perft_results(depth + 1, 0);
+
+    perft(pos, depth, perft_results);
+
+    return perft_results.front();
+}
+
 void Engine::perft_report(Position& pos, int depth)
 {
     assert(depth >= 0);
@@ -3,9 +3,14 @@
 
 #include "position.hpp"
 
+#include <cstdint>
+
 namespace Engine
 {
 
+// number of leaf nodes (legal move paths) depth plies from pos
+uint64_t perft(Position& pos, int depth);
+
 void perft_report(Position& pos, int depth);
 
 void perft_report_divided(Position& pos, int depth);
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <cctype>
 
@@ -5,6 +6,7 @@
 
 #include "./types/bitboard.hpp"
 #include "chessmove.hpp"
+#include "cuckoo.hpp"
 #include "gameinfo.hpp"
 #include "movegen.hpp"
 #include "position.hpp"
@@ -82,24 +84,55 @@ std::ostream& operator<<(std::ostream& out, const Position& p)
     return out;
 }
 
-bool Position::is_rep_draw() const
+bool Position::is_repetition(int search_ply) const
 {
-    auto info_stack_sz = m_state_info_stack.size();
+    // nothing else in the history has the same low bits
+    if (m_rep_filter[rep_filter_idx(m_curr_zhash)] <= 1)
+        return false;
+
+    const size_t info_stack_sz = m_state_info_stack.size();
+
+    // only positions since the last irreversible move can repeat, and only every other one has the same side to move
+    const size_t window = std::min<size_t>(m_rev_move_count, info_stack_sz - 1);
 
-    // number of times current pos is repeated in history
     int number_reps = 0;
 
-    for (size_t i = 2; i <= info_stack_sz; i++)
+    for (size_t i = 4; i <= window; i += 2)
     {
-        if (i != 1
-            && m_state_info_stack[info_stack_sz - i].pos_zhash == m_state_info_stack[info_stack_sz - 1].pos_zhash)
-            number_reps++;
+        if (m_state_info_stack[info_stack_sz - 1 - i].pos_zhash != m_curr_zhash)
+            continue;
 
-        if (!m_state_info_stack[info_stack_sz - i].prev_move_repeatable || number_reps == 3)
-            break;
+        // repeated inside the search tree
+        if (i <= static_cast<size_t>(search_ply))
+            return true;
+
+        if (++number_reps == 2)
+            return true;
+    }
+
+    return false;
+}
+
+bool Position::has_upcoming_repetition(int search_ply) const
+{
+    const size_t info_stack_sz = m_state_info_stack.size();
+
+    const size_t window = std::min<size_t>(m_rev_move_count, info_stack_sz - 1);
+
+    // one move away from positions with the other side to move, at least 3 plies back.
+    // the earlier position must be inside the search tree, a single repetition before the root isn't a draw
+    for (size_t i = 3; i <= window && i < static_cast<size_t>(search_ply); i += 2)
+    {
+        const zhash_t move_key = m_curr_zhash ^ m_state_info_stack[info_stack_sz - 1 - i].pos_zhash;
+
+        square sq1, sq2;
+
+        // the hash difference is a reversible move, and nothing is in the way
+        if (Cuckoo::lookup(move_key, sq1, sq2) && !(bb_between(sq1, sq2) & pieces()))
+            return true;
     }
 
-    return number_reps >= 3;
+    return false;
 }
 
 void Position::dump_move_history() const
@@ -141,6 +174,12 @@ void Position::remove_piece(COLOR c, PIECE p, square sq)
     bb_unset_sq(m_piece_bbs[c][p], sq);
 
     m_curr_zhash ^= Zobrist::color_piece_on_sq(c, p, sq);
+
+    if (p == PAWN)
+        m_pawn_zhash ^= Zobrist::color_piece_on_sq(c, p, sq);
+
+    if (m_acc_update)
+        nnue::remove_piece(m_acc_stack.back(), c, p, sq);
 }
 
 void Position::place_piece(COLOR c, PIECE p, square sq)
@@ -155,6 +194,12 @@ void Position::place_piece(COLOR c, PIECE p, square sq)
     bb_set_sq(m_piece_bbs[c][p], sq);
 
     m_curr_zhash ^= Zobrist::color_piece_on_sq(c, p, sq);
+
+    if (p == PAWN)
+        m_pawn_zhash ^= Zobrist::color_piece_on_sq(c, p, sq);
+
+    if (m_acc_update)
+        nnue::add_piece(m_acc_stack.back(), c, p, sq);
 }
 
 void Position::move_piece(COLOR c, PIECE p, square orig, square dest)
@@ -261,6 +306,15 @@ void Position::make_move(ChessMove move)
     // store reversible move data
     m_state_info_stack.emplace_back(move, m_rev_move_count, m_castle_r, m_enp_sq);
 
+    // push a copy of the accumulator, the piece helpers will update it.
+    // if the previous one isn't up to date, this one will be computed when it's needed
+    if (nnue::enabled())
+    {
+        m_acc_update = !m_acc_stack.empty() && nnue::up_to_date(m_acc_stack.back());
+        m_acc_stack.push_back(m_acc_update ? m_acc_stack.back() : nnue::accumulator{});
+        m_state_info_stack.back().acc_pushed = true;
+    }
+
     // increment rev move counter (will be reset later if it needs to)
     m_rev_move_count += 1;
 
@@ -377,8 +431,11 @@ void Position::make_move(ChessMove move)
 
     m_curr_zhash ^= Zobrist::castle_right(m_castle_r);
 
+    m_acc_update = false;
+
     // *** update state_info ***
     m_state_info_stack.back().pos_zhash = m_curr_zhash;
+    m_rep_filter[rep_filter_idx(m_curr_zhash)]++;
     update_checkers_bb();
 
     if (m_state_info_stack.back().prev_castle_r != m_castle_r)
@@ -392,8 +449,18 @@ void Position::unmake_last()
     const state_info st_info = m_state_info_stack.back();
     m_state_info_stack.pop_back();
 
+    m_rep_filter[rep_filter_idx(st_info.pos_zhash)]--;
+
     const ChessMove move = st_info.prev_move;
 
+    // the accumulator before the move is still below on the stack.
+    // if the move didn't push one (nnue was off), the top one may have been computed after the move
+    // (nnue turned on since), so it has to be recomputed for the position we go back to
+    if (st_info.acc_pushed)
+        m_acc_stack.pop_back();
+    else if (!m_acc_stack.empty())
+        m_acc_stack.back().generation = 0;
+
     m_curr_zhash ^= Zobrist::castle_right(m_castle_r);
     if (is_valid(m_enp_sq))
         m_curr_zhash ^= Zobrist::ep_square(m_enp_sq);
@@ -454,6 +521,18 @@ void Position::unmake_last()
     }
 }
 
+const nnue::accumulator& Position::nnue_accumulator()
+{
+    if (m_acc_stack.empty())
+        m_acc_stack.emplace_back();
+
+    // never computed, or computed with an older network
+    if (!nnue::up_to_date(m_acc_stack.back()))
+        nnue::refresh(*this, m_acc_stack.back());
+
+    return m_acc_stack.back();
+}
+
 // try to make pseudo legal move.
 // If move is legal, make the move and return true.
 // If move is not legal, return false.
@@ -621,9 +700,176 @@ Position::Position(const std::string fenstr) : m_piece_bbs{{0}}, m_color_bbs{0},
     // now we must add a state info for the startpos (are these values okay?)
     m_state_info_stack.emplace_back(ChessMove{}, 0, m_castle_r, BB_ZERO);
     m_state_info_stack.back().pos_zhash = m_curr_zhash;
+    m_rep_filter[rep_filter_idx(m_curr_zhash)]++;
     update_checkers_bb();
 }
 
+bool Position::validate_fen(const std::string& fen, std::string& error)
+{
+    std::istringstream       stream{fen};
+    std::vector<std::string> fields;
+
+    for (std::string field; stream >> field;)
+        fields.push_back(field);
+
+    if (fields.size() < 4 || fields.size() > 6)
+    {
+        error = "expected 4 to 6 fields, found " + std::to_string(fields.size());
+        return false;
+    }
+
+    // ---- board section: 8 ranks of 8 squares, top rank first ----
+    int rank     = 8;
+    int file     = 1;
+    int kings[2] = {0, 0};
+
+    for (char fc : fields[0])
+    {
+        if (fc == '/')
+        {
+            if (file != 9 || rank == 1)
+            {
+                error = "rank " + std::to_string(rank) + " doesn't have 8 squares";
+                return false;
+            }
+
+            rank--;
+            file = 1;
+            continue;
+        }
+
+        if (fc >= '1' && fc <= '8')
+            file += fc - '0';
+        else
+        {
+            const ColorPiece cp = char_to_colorpiece(fc);
+
+            if (cp.piece == NO_PIECE)
+            {
+                error = std::string("unexpected char '") + fc + "' in the board";
+                return false;
+            }
+
+            if (cp.piece == PAWN && (rank == 1 || rank == 8))
+            {
+                error = "pawn on rank " + std::to_string(rank);
+                return false;
+            }
+
+            if (cp.piece == KING)
+                kings[cp.color]++;
+
+            file++;
+        }
+
+        if (file > 9)
+        {
+            error = "rank " + std::to_string(rank) + " doesn't have 8 squares";
+            return false;
+        }
+    }
+
+    if (rank != 1 || file != 9)
+    {
+        error = "the board doesn't have 8 ranks";
+        return false;
+    }
+
+    if (kings[WHITE] != 1 || kings[BLACK] != 1)
+    {
+        error = "each side needs exactly one king";
+        return false;
+    }
+
+    // ---- side to move, castle rights, en passante, counters ----
+    if (fields[1] != "w" && fields[1] != "b")
+    {
+        error = "side to move must be 'w' or 'b'";
+        return false;
+    }
+
+    const COLOR stm = fields[1] == "b" ? BLACK : WHITE;
+
+    if (fields[2] != "-")
+    {
+        for (size_t i = 0; i < fields[2].size(); i++)
+        {
+            if (std::string("KQkq").find(fields[2][i]) == std::string::npos
+                || fields[2].find(fields[2][i], i + 1) != std::string::npos)
+            {
+                error = "invalid castle rights '" + fields[2] + "'";
+                return false;
+            }
+        }
+    }
+
+    // the target square is behind a pawn that just double pushed
+    const char ep_rank = stm == WHITE ? '6' : '3';
+
+    if (fields[3] != "-"
+        && (fields[3].size() != 2 || fields[3][0] < 'a' || fields[3][0] > 'h' || fields[3][1] != ep_rank))
+    {
+        error = "invalid en passante square '" + fields[3] + "'";
+        return false;
+    }
+
+    for (size_t i = 4; i < fields.size(); i++)
+    {
+        if (!std::all_of(fields[i].begin(), fields[i].end(), [](unsigned char c) { return std::isdigit(c); }))
+        {
+            error = "invalid move counter '" + fields[i] + "'";
+            return false;
+        }
+    }
+
+    // ---- now it can be read: check what depends on the pieces ----
+    const Position pos{fen};
+
+    // the king and rook of each right haven't moved
+    const struct
+    {
+        char   right;
+        COLOR  color;
+        square king_sq;
+        square rook_sq;
+    } castles[] = {{'K', WHITE, rf_to_sq(1, 5), rf_to_sq(1, 8)},
+                   {'Q', WHITE, rf_to_sq(1, 5), rf_to_sq(1, 1)},
+                   {'k', BLACK, rf_to_sq(8, 5), rf_to_sq(8, 8)},
+                   {'q', BLACK, rf_to_sq(8, 5), rf_to_sq(8, 1)}};
+
+    for (const auto& castle : castles)
+    {
+        if (fields[2].find(castle.right) == std::string::npos)
+            continue;
+
+        if (!bb_is_set_at_sq(pos.pieces(castle.color, KING), castle.king_sq)
+            || !bb_is_set_at_sq(pos.pieces(castle.color, ROOK), castle.rook_sq))
+        {
+            error = std::string("castle right '") + castle.right + "' without the king and rook in place";
+            return false;
+        }
+    }
+
+    if (fields[3] != "-")
+    {
+        const square ep_sq = rf_to_sq(ep_rank - '0', fields[3][0] - 'a' + 1);
+
+        if (pos.piece_at_sq(ep_sq) != NO_PIECE || !bb_is_set_at_sq(pos.pieces(!stm, PAWN), ep_sq - push_dir(stm)))
+        {
+            error = "en passante square '" + fields[3] + "' without a pawn that double pushed";
+            return false;
+        }
+    }
+
+    if (pos.sq_attacked(lsb(pos.pieces(!stm, KING)), stm))
+    {
+        error = "the side to move can take the king";
+        return false;
+    }
+
+    return true;
+}
+
 std::string Position::FEN() const
 {
     std::string fen_buf{15, ' '};
@@ -4,6 +4,7 @@
 #include "./types/bitboard.hpp"
 #include "./types/pieces.hpp"
 #include "chessmove.hpp"
+#include "nnue.hpp"
 #include "zobrist.hpp"
 
 #include <array>
@@ -26,6 +27,9 @@ struct state_info
     bool    prev_move_repeatable{true};
     zhash_t pos_zhash;
 
+    // did the move push an nnue accumulator
+    bool acc_pushed{false};
+
     // need a constructor to use emplace_back
     state_info(ChessMove cm, unsigned int rmc, unsigned int pcr, square pesq)
         : prev_move(cm), prev_rev_move_count(rmc), prev_castle_r(pcr), prev_enp_sq(pesq)
@@ -62,12 +66,29 @@ class Position
 
     zhash_t m_curr_zhash;
 
+    // hash of pawns only (for the pawn hash table)
+    zhash_t m_pawn_zhash{0};
+
+    // how many positions in the state info stack have each low bits of the hash.
+    // if the current position's count is 1 (itself), it can't be a repetition, and we don't have to scan
+    static constexpr size_t rep_filter_size = (1 << 12);
+    std::array<uint16_t, rep_filter_size> m_rep_filter{};
+
+    static size_t rep_filter_idx(zhash_t hash) { return hash & (rep_filter_size - 1); }
+
     unsigned int m_castle_r;
     unsigned int m_rev_move_count;
     unsigned int m_full_moves;
 
     COLOR m_stm{WHITE};
 
+    // nnue accumulators, one pushed per move while nnue is enabled.
+    // the top one is only valid for the current position if it is up to date
+    std::vector<nnue::accumulator> m_acc_stack{};
+
+    // true while make_move can update the top accumulator incrementally
+    bool m_acc_update{false};
+
     // helpers
     void remove_piece(COLOR c, PIECE p, square sq);
     void place_piece(COLOR c, PIECE p, square sq);
@@ -83,9 +104,15 @@ class Position
     void update_checkers_bb();
 
   public:
-    // default to the starting position
+    // default to the starting position.
+    // NOTE: the fen parser isn't forgiving, a malformed fen can end the program (check it with validate_fen first)
     Position(std::string fenstr = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
 
+    // false (and error says why) if fen isn't a position the engine can play from:
+    // malformed, not one king a side, castle rights or en passante the pieces don't allow, or the side to move can
+    // take the king. The move counters are optional (EPD)
+    static bool validate_fen(const std::string& fen, std::string& error);
+
     inline const COLOR& side_to_move() const { return m_stm; }
 
     // self explanatory but the rules of chess aren't
@@ -94,11 +121,19 @@ class Position
     // if the side to move has legal moves, draw, else checkmated
     inline bool has_been_50_reversible_full_moves() { return m_rev_move_count >= 100; }
 
-    bool is_rep_draw() const;
+    // draw by repetition: the position occurred twice before (threefold repetition).
+    // Within the last search_ply plies (the search tree) a single earlier occurrence is enough,
+    // because the side that repeated can always repeat again
+    bool is_repetition(int search_ply = 0) const;
+
+    // the side to move has a reversible move which repeats a position from the last search_ply plies,
+    // so it can at least draw
+    bool has_upcoming_repetition(int search_ply) const;
 
     inline const unsigned int& full_move_count() const { return m_full_moves; }
     inline const unsigned int& rev_move_count() const { return m_rev_move_count; }
     inline square              en_passante_sq() const { return m_enp_sq; }
+    inline unsigned int        castle_rights() const { return m_castle_r; }
 
     PIECE piece_at_sq(square sq) const;
     COLOR color_at_sq(square sq) const;
@@ -110,6 +145,12 @@ class Position
 
     move_list legal_moves();
 
+    // cheaper than generating legal moves, when we only need to know if there are any
+    bool has_legal_move() const;
+
+    // pieces of both colors attacking sq, with occupancy occ
+    bitboard attackers_to(square sq, bitboard occ) const;
+
     const bitboard& get_checkers_bb() const { return m_state_info_stack.back().checkers_bb; }
 
     bool is_check() const { return get_checkers_bb(); }
@@ -117,6 +158,10 @@ class Position
     const ChessMove& last_move() const { return m_state_info_stack.back().prev_move; }
 
     zhash_t zhash() const { return m_curr_zhash; }
+    zhash_t pawn_zhash() const { return m_pawn_zhash; }
+
+    // current nnue accumulator, computed from scratch if it couldn't be updated incrementally
+    const nnue::accumulator& nnue_accumulator();
 
     void make_move(const ChessMove c);
     bool try_make_move(const ChessMove c);
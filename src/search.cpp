@@ -1,73 +1,370 @@
 
 #include "search.hpp"
+#include "bitbase.hpp"
 #include "chessmove.hpp"
 #include "evaluate.hpp"
+#include "pawns.hpp"
 #include "position.hpp"
+#include "stats.hpp"
 #include "transposition.hpp"
 
 #include <algorithm>
 #include <cstdint>
+#include <vector>
 
 using Engine::centipawn;
 using namespace Search;
 
-centipawn negamax_search(Position& pos, uint8_t depth, uint32_t& nodes_searched,
-                         centipawn alpha = Engine::NEGATIVE_INF_EVAL, centipawn beta = Engine::POSITIVE_INF_EVAL);
+centipawn negamax_search(Position& pos, uint8_t depth, int ply, search_info& info,
+                         centipawn alpha = Engine::NEGATIVE_INF_EVAL, centipawn beta = Engine::POSITIVE_INF_EVAL,
+                         ChessMove excluded = {});
+
+// singular extensions: only deep enough nodes are worth the verification search,
+// and the tt move is singular when every other move is this much worse per ply of depth
+constexpr int       SINGULAR_MIN_DEPTH = 6;
+constexpr centipawn SINGULAR_MARGIN    = 10;
+
+// extra depth for a move, just made on pos: a check, or the singular tt move, is searched one ply deeper.
+// extensions stop at the info's extension limit, so checks can't make the search endless
+static int extension(const Position& pos, int ply, const search_info& info, bool singular)
+{
+    if (ply >= info.extension_limit)
+        return 0;
+
+    if (singular)
+    {
+        STATS_ADD(singular_extensions, 1);
+        return 1;
+    }
+
+    if (pos.is_check())
+    {
+        STATS_ADD(check_extensions, 1);
+        return 1;
+    }
+
+    return 0;
+}
+
+// triangular pv table: line[ply] is the best line found from ply, made from a move and the child's line.
+// per thread, like the rest of the search state
+struct pv_table
+{
+    ChessMove line[MAX_PLY + 1][MAX_PLY + 1];
+    int       length[MAX_PLY + 1];
+
+    // move is the new best at ply: it's line is the move, then the line from the next ply
+    void update(int ply, ChessMove move)
+    {
+        line[ply][0] = move;
+        std::copy(line[ply + 1], line[ply + 1] + length[ply + 1], line[ply] + 1);
+        length[ply] = length[ply + 1] + 1;
+    }
+};
+
+static thread_local pv_table pv_lines;
+
+// the pv table loses the line where a child returned early (a tt cutoff). follow the tt's best moves from
+// the end of the line, while they're legal and don't repeat a position
+static void extend_pv_from_tt(Position& pos, const tt::table& table, move_list& pv, int depth)
+{
+    std::vector<zhash_t> seen;
+    int                  made = 0;
+
+    for (const ChessMove& move : pv)
+    {
+        seen.push_back(pos.zhash());
+        pos.make_move(move);
+        made++;
+    }
+
+    while (static_cast<int>(pv.size()) < depth)
+    {
+        const tt::entry entry = table.lookup(pos.zhash());
+        seen.push_back(pos.zhash());
+
+        if (!tt::valid_entry(entry) || entry.best_move.get_moved_piece() == NO_PIECE)
+            break;
+
+        const move_list moves = pos.pseudo_legal_moves();
+
+        if (std::find(moves.begin(), moves.end(), entry.best_move) == moves.end() || !pos.try_make_move(entry.best_move))
+            break;
+
+        made++;
+
+        if (std::find(seen.begin(), seen.end(), pos.zhash()) != seen.end())
+            break;
+
+        pv.push_back(entry.best_move);
+    }
+
+    for (; made > 0; made--)
+        pos.unmake_last();
+}
+
+// the stop flag and the clock are only read every this many nodes (the node limit is checked at every node)
+constexpr uint64_t STOP_CHECK_INTERVAL = 1024;
+
+// a limit was reached, or the search was told to stop
+static bool should_stop(const search_info& info)
+{
+    if (info.node_limit && info.nodes_searched >= info.node_limit)
+        return true;
+
+    if (info.nodes_searched % STOP_CHECK_INTERVAL != 0)
+        return false;
+
+    if (info.stop && info.stop->load(std::memory_order_relaxed))
+        return true;
+
+    return info.deadline != std::chrono::steady_clock::time_point::max()
+        && std::chrono::steady_clock::now() >= info.deadline;
+}
+
+// the tt is shared by every ply, so mate scores are stored as plies from the entry's position, not the root
+static centipawn value_to_tt(centipawn value, int ply)
+{
+    if (value >= Engine::MATE_BOUND)
+        return value + ply;
+
+    if (value <= -Engine::MATE_BOUND)
+        return value - ply;
+
+    return value;
+}
+
+static centipawn value_from_tt(centipawn value, int ply)
+{
+    if (value >= Engine::MATE_BOUND)
+        return value - ply;
+
+    if (value <= -Engine::MATE_BOUND)
+        return value + ply;
+
+    return value;
+}
 
 // Finds the best move using search. Essentially a wrapper for the real negamax search,
 // but needed because search returns an evaluation and we want a ChessMove
-search_info Search::negamax_root(Position& pos, int depth)
+search_info Search::negamax_root(Position& pos, const search_params& params, tt::table& table,
+                                 const info_callback& on_info, const currmove_callback& on_currmove)
 {
     // We assume here that the position is not over (the engine wouldn't ask for a best move)
 
-    assert(depth >= 1);
+    assert(params.depth >= 1 && params.multipv >= 1);
+
+    // a mate in n moves is found n moves (2n - 1 plies) deep
+    const int depth = std::min({params.depth, MAX_PLY, params.mate ? 2 * params.mate - 1 : MAX_PLY});
 
     search_info info = {};
 
-    move_list psl = pos.pseudo_legal_moves();
+    info.table      = &table;
+    info.node_limit = params.nodes;
+    info.stop       = params.stop;
+    info.pruning    = params.pruning;
+
+    if (params.movetime)
+        info.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(params.movetime);
+
+    info.root_in_bitbase = Bitbase::probe(pos) != Bitbase::RESULT::UNKNOWN;
+
+    Engine::reset_eval_cache_stats();
+    Pawns::reset_stats();
+    STATS_RESET();
+
+    move_list root_moves = pos.pseudo_legal_moves();
+
+    root_moves.erase(std::remove_if(root_moves.begin(), root_moves.end(),
+                                    [&](ChessMove move) {
+                                        if (!pos.try_make_move(move))
+                                            return true;
 
-    tt::entry entry = tt::lookup(pos.zhash());
-    order_moves(psl, entry.best_move);
+                                        pos.unmake_last();
+                                        return false;
+                                    }),
+                     root_moves.end());
 
-    for (ChessMove move : psl)
+    assert(!root_moves.empty());
+
+    const size_t multipv = std::min<size_t>(params.multipv, root_moves.size());
+
+    // searched first at the first depth (the deeper ones start with the best moves of the last)
+    const ChessMove tt_move = info.table->lookup(pos.zhash()).best_move;
+
+    // iterative deepening: each depth fills the tt (and finds the best moves) to order the next, deeper one
+    for (int d = 1; d <= depth; d++)
     {
-        if (!pos.try_make_move(move))
-            continue;
+        info.extension_limit = std::min(2 * d, MAX_PLY);
 
-        centipawn move_eval =
-            -negamax_search(pos, depth - 1, info.nodes_searched, Engine::NEGATIVE_INF_EVAL, -info.score);
+        order_moves(root_moves, d == 1 ? tt_move : ChessMove{});
 
-        if (move_eval > info.score)
+        // the best moves of the last depth go first, in their order
+        for (size_t i = info.lines.size(); i-- > 0;)
         {
-            info.best_move = move;
-            info.score     = move_eval;
+            auto it = std::find(root_moves.begin(), root_moves.end(), info.lines[i].pv.front());
+            std::rotate(root_moves.begin(), it, it + 1);
         }
 
-        pos.unmake_last();
+        std::vector<pv_line> lines;
+
+        // multipv: each line is the best of the moves the lines before it didn't take.
+        // later lines are cheap, the moves were just searched (with a narrower window) and are in the tt
+        for (size_t line_num = 0; line_num < multipv; line_num++)
+        {
+            centipawn best_eval = Engine::NEGATIVE_INF_EVAL;
+
+            pv_lines.length[0] = 0;
+
+            for (size_t i = 0; i < root_moves.size(); i++)
+            {
+                const ChessMove move = root_moves[i];
+
+                const bool taken = std::any_of(lines.begin(), lines.end(),
+                                               [&](const pv_line& line) { return line.pv.front() == move; });
+
+                if (taken)
+                    continue;
+
+                if (on_currmove)
+                    on_currmove(move, static_cast<int>(i) + 1, d);
+
+                pos.make_move(move);
+
+                const int child_depth = d - 1 + extension(pos, 0, info, false);
+                centipawn move_eval =
+                    -negamax_search(pos, child_depth, 1, info, Engine::NEGATIVE_INF_EVAL, -best_eval);
+
+                pos.unmake_last();
+
+                if (info.stopped)
+                    break;
+
+                if (move_eval > best_eval)
+                {
+                    best_eval = move_eval;
+                    pv_lines.update(0, move);
+                }
+            }
+
+            // stopped before a move was searched, the line has nothing
+            if (pv_lines.length[0] == 0)
+                break;
+
+            pv_line line;
+            line.score = best_eval;
+            line.pv.assign(pv_lines.line[0], pv_lines.line[0] + pv_lines.length[0]);
+
+            if (!info.stopped)
+                extend_pv_from_tt(pos, *info.table, line.pv, d);
+
+            lines.push_back(line);
+
+            if (info.stopped)
+                break;
+        }
+
+        // an unfinished depth only counts if there's nothing better: the first one, stopped early
+        if (info.stopped && !info.lines.empty())
+            break;
+
+        // stopped before any move was searched
+        if (lines.empty())
+        {
+            pv_line line;
+            line.pv = {root_moves.front()};
+            lines.push_back(line);
+        }
+
+        info.lines     = lines;
+        info.depth     = d;
+        info.best_move = lines[0].pv.front();
+        info.score     = lines[0].score;
+        info.pv        = lines[0].pv;
+
+        if (info.stopped)
+            break;
+
+        if (on_info)
+            on_info(info);
+
+        // the mate is proven, deeper searches would only find it again
+        if (params.mate && info.score >= Engine::MATE_BOUND && Engine::mate_moves(info.score) <= params.mate)
+            break;
     }
 
-    assert(!info.best_move.is_null());
+    STATS_ADD(eval_cache_probes, Engine::eval_cache_stats().probes);
+    STATS_ADD(eval_cache_hits, Engine::eval_cache_stats().hits);
+    STATS_ADD(pawn_hash_probes, Pawns::stats().probes);
+    STATS_ADD(pawn_hash_hits, Pawns::stats().hits);
+    STATS_PUBLISH();
 
     return info;
 }
 
 // https://en.wikipedia.org/wiki/Negamax
-centipawn negamax_search(Position& pos, uint8_t depth, uint32_t& nodes_searched, centipawn alpha, centipawn beta)
+// ply is the distance from the root. the excluded move isn't searched (the singular extension's
+// verification search): the result isn't the position's, so it's not stored, nor cut off by the tt
+centipawn negamax_search(Position& pos, uint8_t depth, int ply, search_info& info, centipawn alpha, centipawn beta,
+                         ChessMove excluded)
 {
+    pv_lines.length[ply] = 0;
+    info.seldepth        = std::max(info.seldepth, ply);
+
+    // too deep for the pv table
+    if (ply >= MAX_PLY)
+        return Engine::static_eval(pos);
+
     // rep draw is a special case: always draw, we don't care about the tt or anything else
-    if (pos.is_rep_draw())
+    if (pos.is_repetition(ply))
         return Engine::DRAW_EVAL;
 
+    // we can repeat a position with one move, so we can at least draw
+    if (alpha < Engine::DRAW_EVAL && pos.has_upcoming_repetition(ply))
+    {
+        alpha = Engine::DRAW_EVAL;
+
+        if (alpha >= beta)
+            return alpha;
+    }
+
+    // mate distance pruning: mated right here is the worst this node can score, mating with the next move the best.
+    // if a shorter mate is already known, the window is empty
+    alpha = std::max(alpha, Engine::mated_in(ply));
+    beta  = std::min(beta, Engine::mate_in(ply + 1));
+
+    if (alpha >= beta)
+        return alpha;
+
+    // small endgames are known exactly, no need to search them.
+    // (game over is left to the usual code, it scores mate by depth)
+    const Bitbase::RESULT bitbase_result = Bitbase::probe(pos);
+
+    if (!info.root_in_bitbase && bitbase_result != Bitbase::RESULT::UNKNOWN
+        && Engine::game_state(pos) == Engine::GAME_STATE::ONGOING)
+    {
+        STATS_ADD(bitbase_hits, 1);
+        return Engine::bitbase_eval(pos, bitbase_result);
+    }
+
     // probe tt to see if we've seen this position
-    tt::entry entry     = tt::lookup(pos.zhash());
+    tt::entry entry     = info.table->lookup(pos.zhash());
     centipawn alphaOrig = alpha;
 
+    entry.value = value_from_tt(entry.value, ply);
+
+    STATS_ADD(tt_probes, 1);
+    STATS_ADD(tt_hits, tt::valid_entry(entry));
+
     // if the position has been seen, and we've
     //  searched below at least 'depth' amount
-    if (tt::valid_entry(entry) && entry.depth >= depth)
+    if (excluded.is_null() && tt::valid_entry(entry) && entry.depth >= depth)
     {
         if (entry.node_type == tt::NODE_TYPE::PV)
+        {
+            STATS_ADD(tt_cutoffs, 1);
             return entry.value;
+        }
 
         // lowerbound
         else if (entry.node_type == tt::NODE_TYPE::CUT)
@@ -79,57 +376,204 @@ centipawn negamax_search(Position& pos, uint8_t depth, uint32_t& nodes_searched,
 
         // cause cutoff if found
         if (alpha >= beta)
+        {
+            STATS_ADD(tt_cutoffs, 1);
             return entry.value;
+        }
     }
 
-    // generate pseudolegal moves,
-    // we need to generate them to check if the position is checkmate
-    move_list psl_moves = pos.pseudo_legal_moves();
-
     centipawn best_eval = Engine::NEGATIVE_INF_EVAL;
     ChessMove best_move = {};
-    nodes_searched += 1;
+    info.nodes_searched += 1;
+    STATS_ADD(nodes_per_ply[std::min(ply, Stats::MAX_PLY - 1)], 1);
 
-    // note: this statement doesn't cover every game over case.
-    // in many stalemate/checkmate cases, we will reach to the end of this function,
-    // so don't assume the game isn't over now
-    if (depth == 0 || pos.has_been_50_reversible_full_moves() || psl_moves.size() == 0)
+    // unwind without storing anything, the result of an unfinished search is thrown away
+    if (should_stop(info))
     {
-        best_eval = Engine::evaluate(pos, psl_moves);
+        info.stopped = true;
+        return 0;
+    }
+
+    // leaf: check if the game is over without generating moves, else use the static eval.
+    // interior nodes find checkmate/stalemate themselves (when no legal move is searched below)
+    if (depth == 0 || pos.has_been_50_reversible_full_moves())
+    {
+        STATS_ADD(leaf_evals, 1);
+
+        // we may have evaluated this position before, as an interior node
+        centipawn                static_eval = entry.static_eval;
+        const Engine::GAME_STATE state       = Engine::game_state(pos);
+
+        if (state == Engine::GAME_STATE::CHECKMATE)
+            best_eval = Engine::mated_in(ply);
+
+        else if (state != Engine::GAME_STATE::ONGOING)
+            best_eval = Engine::game_over_eval(state);
+
+        else
+        {
+            if (tt::valid_entry(entry) && static_eval != tt::NO_STATIC_EVAL)
+                STATS_ADD(tt_eval_hits, 1);
+            else
+            {
+                STATS_TIMER(EVAL);
+                static_eval = Engine::static_eval(pos);
+            }
+
+            best_eval = static_eval;
+
+            if (bitbase_result != Bitbase::RESULT::UNKNOWN)
+            {
+                STATS_ADD(bitbase_hits, 1);
+                best_eval = Engine::bitbase_eval(pos, bitbase_result);
+            }
+        }
+
+        // store the leaf, so the next visit can return at the tt probe without evaluating.
+        // not a leaf because of the 50 move rule though: the hash doesn't know the move counter, and depth may be > 0
+        if (!pos.has_been_50_reversible_full_moves())
+        {
+            entry             = {};
+            entry.full_hash   = pos.zhash();
+            entry.value       = value_to_tt(best_eval, ply);
+            entry.static_eval = static_eval;
+            entry.depth       = depth;
+            entry.node_type   = tt::NODE_TYPE::PV;
+
+            info.table->store(entry);
+        }
+
         return best_eval;
     }
 
-    // order moves to create earlier cutoffs
-    order_moves(psl_moves, entry.best_move);
+    // shallow depth pruning (see pruning_params) works from the static eval, it's stored with the node
+    const pruning_params& pruning = info.pruning;
+    const bool            shallow = depth <= pruning.max_depth && !pos.is_check();
+
+    if (shallow && entry.static_eval == tt::NO_STATIC_EVAL)
+    {
+        STATS_TIMER(EVAL);
+        entry.static_eval = Engine::static_eval(pos);
+    }
+
+    // reverse futility pruning (static null move): far enough above beta that no reply is likely to bring it back
+    if (shallow && pruning.reverse_futility && excluded.is_null() && !Engine::is_mate_score(beta)
+        && entry.static_eval - pruning.reverse_futility * depth >= beta)
+    {
+        STATS_ADD(pruned, 1);
+        return entry.static_eval - pruning.reverse_futility * depth;
+    }
+
+    // futility pruning: far enough below alpha that only captures, promotions and checks could raise it
+    const bool futile = shallow && pruning.futility && !Engine::is_mate_score(alpha)
+                        && entry.static_eval + pruning.futility * depth <= alpha;
+
+    move_list psl_moves;
+
+    {
+        STATS_TIMER(MOVEGEN);
+        psl_moves = pos.pseudo_legal_moves();
+
+        // order moves to create earlier cutoffs
+        order_moves(psl_moves, entry.best_move);
+    }
+
+    // singular extension: is the tt move the only good move here? search the others shallower, with a null
+    // window below the tt move's value (a lower bound, or exact, from a search not much shallower than this one).
+    // if they all fail low, the tt move is singular and searched deeper
+    bool singular = false;
+
+    if (excluded.is_null() && depth >= SINGULAR_MIN_DEPTH && ply < info.extension_limit && tt::valid_entry(entry)
+        && !entry.best_move.is_null() && entry.node_type != tt::NODE_TYPE::ALL && entry.depth >= depth - 3
+        && !Engine::is_mate_score(entry.value))
+    {
+        const centipawn singular_beta = entry.value - SINGULAR_MARGIN * depth;
+        const centipawn value =
+            negamax_search(pos, (depth - 1) / 2, ply, info, singular_beta - 1, singular_beta, entry.best_move);
+
+        if (info.stopped)
+            return 0;
+
+        singular = value < singular_beta;
+
+        // the verification search used this ply's line
+        pv_lines.length[ply] = 0;
+    }
+
+    // legal moves searched so far, and legal moves seen (searched or pruned)
+    [[maybe_unused]] int move_index  = 0;
+    int                  legal_moves = 0;
 
     for (ChessMove move : psl_moves)
     {
+        bool legal;
+
+        if (move == excluded)
+            continue;
+
+        {
+            STATS_TIMER(MAKE_UNMAKE);
+            legal = pos.try_make_move(move);
+        }
+
         // skip illegal moves
-        if (!pos.try_make_move(move))
+        if (!legal)
             continue;
 
-        centipawn node_eval = -negamax_search(pos, depth - 1, nodes_searched, -beta, -alpha);
+        legal_moves++;
 
-        // the move we are currently searching is the new best
-        if (node_eval >= best_eval)
+        // prune quiet moves that are futile, or late (they're in no particular order, so most of them are).
+        // never the first move, nor while every move so far gets mated: the node could look like a mate
+        if (shallow && legal_moves > 1 && best_eval > -Engine::MATE_BOUND && !move.is_capture() && !move.is_promo()
+            && !pos.is_check() && (futile || (pruning.late_move && legal_moves > pruning.late_move + depth * depth)))
+        {
+            {
+                STATS_TIMER(MAKE_UNMAKE);
+                pos.unmake_last();
+            }
+
+            STATS_ADD(pruned, 1);
+            continue;
+        }
+
+        const int child_depth = depth - 1 + extension(pos, ply, info, singular && move == entry.best_move);
+        centipawn node_eval   = -negamax_search(pos, child_depth, ply + 1, info, -beta, -alpha);
+
+        // the move we are currently searching is the new best (a tie keeps the earlier move: the tt move is
+        // the one that reached the score, like the pv)
+        if (node_eval > best_eval)
         {
             best_move = move;
             best_eval = node_eval;
         }
 
         // unmake move
-        pos.unmake_last();
+        {
+            STATS_TIMER(MAKE_UNMAKE);
+            pos.unmake_last();
+        }
+
+        if (info.stopped)
+            return 0;
 
         // if the best eval becomes better than alpha, it is the new best globally
-        if (best_eval >= alpha)
+        // (only this move can have raised best_eval past alpha)
+        if (best_eval > alpha)
         {
-            alpha     = best_eval;
-            best_move = move;
+            alpha = best_eval;
+            pv_lines.update(ply, move);
         }
 
         // cause cutoff, move proven worse than other alternatives
         if (alpha >= beta)
+        {
+            STATS_ADD(beta_cutoffs, 1);
+            STATS_ADD(first_move_cutoffs, move_index == 0);
+            STATS_ADD(cutoff_move_index[std::min(move_index, Stats::CUTOFF_INDEX_BUCKETS - 1)], 1);
             break;
+        }
+
+        move_index++;
     }
 
     // If node_eval is still negative infinite, no legal move was found.
@@ -137,20 +581,28 @@ centipawn negamax_search(Position& pos, uint8_t depth, uint32_t& nodes_searched,
 
     if (best_eval == Engine::NEGATIVE_INF_EVAL)
     {
+        // the excluded move was the only one: nothing else comes close
+        if (!excluded.is_null())
+            return alpha;
+
         // NOTE: don't use evaluate function here because it has to check for checkmate, it does
         // this by searching for a legal move. we already know if their was or wasn't a legal move
 
         // also don't bother entering this node into the TT, since their are no child nodes, it won't save time.
         if (pos.is_check())
-            return Engine::LOST_EVAL + Engine::tempo_penalty(depth);
+            return Engine::mated_in(ply);
         else
             return Engine::DRAW_EVAL + Engine::tempo_penalty(depth);
     }
 
-    // Now: store tt entry and return
+    // a search without the excluded move says nothing about the position
+    if (!excluded.is_null())
+        return best_eval;
 
+    // Now: store tt entry and return
+    // (entry is still the probed entry, so it keeps the static eval if one was known for this position)
     entry.full_hash = pos.zhash();
-    entry.value     = best_eval;
+    entry.value     = value_to_tt(best_eval, ply);
     entry.best_move = best_move;
     entry.depth     = depth;
 
@@ -167,7 +619,7 @@ centipawn negamax_search(Position& pos, uint8_t depth, uint32_t& nodes_searched,
         entry.node_type = tt::NODE_TYPE::PV;
 
     // store node info in the tranposition table
-    tt::store(entry);
+    info.table->store(entry);
 
     return best_eval;
 }
@@ -2,22 +2,111 @@
 #define SEARCH_INCL
 #include "chessmove.hpp"
 #include "evaluate.hpp"
+#include "transposition.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
 
 using Engine::centipawn;
 
 namespace Search
 {
 
+// deepest ply the search reaches (the pv table is this big)
+constexpr int MAX_PLY = 128;
+
+// shallow depth pruning near the leaves (UCI options, so it's strength cost can be measured in self-play).
+// never in check, nor for captures, promotions or checks. a margin of 0 turns that pruning off
+struct pruning_params
+{
+    int max_depth = 3; // prune at this depth and below
+
+    int reverse_futility = 100; // cp per ply: a node whose static eval is this far above beta fails high
+    int futility         = 150; // cp per ply: quiet moves are skipped when the static eval is this far below alpha
+    int late_move        = 8;   // quiet moves are skipped after late_move + depth * depth legal moves
+};
+
+// what to search
+struct search_params
+{
+    int depth   = 1;
+    int multipv = 1; // how many best lines to find (they're searched one after another, sharing the tt)
+
+    // limits (0: none). a search stopped by a limit keeps the result of the last depth it finished
+    uint64_t nodes    = 0; // stop after searching this many nodes. the same search always stops at the same node
+    int      mate     = 0; // look for a mate in this many moves: search up to 2 * mate - 1 plies, stop when found
+    int64_t  movetime = 0; // stop after this many milliseconds
+
+    // set (by another thread) to stop the search
+    const std::atomic<bool>* stop = nullptr;
+
+    pruning_params pruning = {};
+};
+
+// one of the best lines (multipv)
+struct pv_line
+{
+    centipawn score = Engine::NEGATIVE_INF_EVAL;
+    move_list pv;
+};
+
 struct search_info
 {
+    // the table this search uses
+    tt::table* table = nullptr;
+
+    int       depth    = 0;
+    int       seldepth = 0; // deepest ply reached
     ChessMove best_move{};
 
-    uint32_t nodes_searched = 0;
+    // moves aren't extended past this ply (twice the depth being searched)
+    int extension_limit = 0;
+
+    // principal variation: best_move, then the best play that follows
+    move_list pv;
+
+    // the best lines, best first (lines[0] is score and pv above). as many as multipv, or the legal moves
+    std::vector<pv_line> lines;
+
+    uint64_t nodes_searched = 0;
+    uint64_t node_limit     = 0; // see search_params
+
+    // when movetime runs out (no limit if it's max)
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    const std::atomic<bool>* stop = nullptr;
+
+    pruning_params pruning; // see search_params
+
+    // a limit was reached or stop was set: the depth being searched wasn't finished
+    bool stopped = false;
 
     centipawn score = Engine::NEGATIVE_INF_EVAL;
+
+    // the root is a bitbase position already: search normally, and use the bitbases at the leaves only
+    // (else every child returns immediately, and the search can't find the way to convert the win)
+    bool root_in_bitbase = false;
 };
 
-search_info negamax_root(Position& pos, int depth);
+// called with the search info when a search (of a depth) is done
+using info_callback = std::function<void(const search_info&)>;
+
+// called when the search starts on a root move. move_number counts from 1
+using currmove_callback = std::function<void(ChessMove move, int move_number, int depth)>;
+
+// iterative deepening: searches depth 1, 2... up to params.depth. on_info is called after each one
+search_info negamax_root(Position& pos, const search_params& params, tt::table& table = tt::global(),
+                         const info_callback& on_info = {}, const currmove_callback& on_currmove = {});
+
+// search for the best move only
+inline search_info negamax_root(Position& pos, int depth, tt::table& table = tt::global(),
+                                const info_callback& on_info = {})
+{
+    return negamax_root(pos, search_params{depth}, table, on_info);
+}
 
 } // namespace Search
 #endif // SEARCH_INCL
\ No newline at end of file
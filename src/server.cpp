@@ -0,0 +1,234 @@
+#include "server.hpp"
+#include "engine.hpp"
+#include "evaluate.hpp"
+#include "instance.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+static constexpr int DEFAULT_SERVER_DEPTH = 4;
+
+struct session
+{
+    std::string      id;
+    Engine::instance engine;
+
+    // commands waiting to run (guarded by the scheduler mutex)
+    std::deque<std::vector<std::string>> pending;
+
+    // in the ready queue, or running on a worker
+    bool scheduled = false;
+
+    session(const std::string& session_id, size_t tt_entries) : id(session_id), engine(tt_entries) {}
+};
+
+// sessions with pending commands wait in the ready queue. A worker takes a session, runs one command,
+// and puts the session back at the end if it has more: sessions take turns, and a session never runs on two workers
+struct scheduler
+{
+    std::mutex              mutex;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+
+    std::deque<std::shared_ptr<session>> ready;
+
+    int  running  = 0;
+    bool stopping = false;
+};
+
+// one write per line, so lines from different workers don't mix
+static std::mutex output_mutex;
+
+static void send_line(const std::string& line)
+{
+    std::lock_guard<std::mutex> lock{output_mutex};
+    std::cout << line << '\n' << std::flush;
+}
+
+static void run_command(session& s, const std::vector<std::string>& tokens)
+{
+    const std::string& cmd = tokens[0];
+
+    if (cmd == "position")
+    {
+        if (!s.engine.set_position(tokens))
+            send_line(s.id + " error invalid position");
+    }
+    else if (cmd == "go")
+    {
+        Search::search_params params;
+        bool                  infinite;
+
+        // the same limits as uci go. infinite ends with stop
+        if (!Engine::parse_go_limits(tokens, DEFAULT_SERVER_DEPTH, params, infinite))
+        {
+            send_line(s.id + " error invalid go command");
+            return;
+        }
+
+        // nothing to search
+        if (Engine::game_state(s.engine.position()) != Engine::GAME_STATE::ONGOING)
+        {
+            send_line(s.id + " bestmove 0000");
+            return;
+        }
+
+        const Search::search_info info = s.engine.search(params);
+
+        send_line(s.id + " info depth " + std::to_string(info.depth) + " score " + Engine::UCI_score(info.score) + " nodes "
+                  + std::to_string(info.nodes_searched));
+        send_line(s.id + " bestmove " + info.best_move.to_str());
+    }
+    else if (cmd == "ucinewgame")
+        s.engine.new_game();
+
+    else
+        send_line(s.id + " error unknown command " + cmd);
+}
+
+static void worker(scheduler& sched)
+{
+    std::unique_lock<std::mutex> lock{sched.mutex};
+
+    while (true)
+    {
+        sched.work_available.wait(lock, [&] { return sched.stopping || !sched.ready.empty(); });
+
+        if (sched.ready.empty())
+            return; // stopping, and nothing left to do
+
+        std::shared_ptr<session> s = sched.ready.front();
+        sched.ready.pop_front();
+
+        std::vector<std::string> tokens = std::move(s->pending.front());
+        s->pending.pop_front();
+
+        sched.running++;
+        lock.unlock();
+
+        run_command(*s, tokens);
+
+        lock.lock();
+        sched.running--;
+
+        if (!s->pending.empty())
+        {
+            sched.ready.push_back(s);
+            sched.work_available.notify_one();
+        }
+        else
+            s->scheduled = false;
+
+        if (sched.ready.empty() && sched.running == 0)
+            sched.all_done.notify_all();
+    }
+}
+
+void Server::run(int threads, size_t tt_entries)
+{
+    scheduler sched;
+
+    std::vector<std::thread> workers;
+
+    for (int i = 0; i < std::max(1, threads); i++)
+        workers.emplace_back(worker, std::ref(sched));
+
+    // only this thread adds and removes sessions, workers keep the ones they are running alive
+    std::unordered_map<std::string, std::shared_ptr<session>> sessions;
+
+    std::string line_buf;
+
+    while (std::getline(std::cin, line_buf))
+    {
+        std::istringstream line{line_buf};
+
+        std::vector<std::string> tokens;
+
+        for (std::string token; line >> token;)
+            tokens.push_back(token);
+
+        if (tokens.empty())
+            continue;
+
+        if (tokens[0] == "quit")
+            break;
+
+        if (tokens[0] == "stats")
+        {
+            size_t memory = 0;
+
+            for (const auto& [id, s] : sessions)
+                memory += s->engine.memory_bytes();
+
+            send_line("stats sessions " + std::to_string(sessions.size()) + " memory " + std::to_string(memory));
+            continue;
+        }
+
+        if (tokens.size() < 2)
+        {
+            send_line(tokens[0] + " error no command");
+            continue;
+        }
+
+        const std::string id = tokens[0];
+        tokens.erase(tokens.begin());
+
+        if (tokens[0] == "stop")
+        {
+            // not queued behind the search it stops. ignored if the session has nothing queued or running,
+            // else it would stop the session's next search
+            auto it = sessions.find(id);
+
+            std::lock_guard<std::mutex> lock{sched.mutex};
+
+            if (it != sessions.end() && it->second->scheduled)
+                it->second->engine.stop();
+
+            continue;
+        }
+
+        if (tokens[0] == "close")
+        {
+            // commands already queued still run
+            sessions.erase(id);
+            continue;
+        }
+
+        std::shared_ptr<session>& s = sessions[id];
+
+        if (!s)
+            s = std::make_shared<session>(id, tt_entries);
+
+        std::lock_guard<std::mutex> lock{sched.mutex};
+
+        s->pending.push_back(std::move(tokens));
+
+        if (!s->scheduled)
+        {
+            s->scheduled = true;
+            sched.ready.push_back(s);
+            sched.work_available.notify_one();
+        }
+    }
+
+    // finish everything that was asked for
+    {
+        std::unique_lock<std::mutex> lock{sched.mutex};
+        sched.all_done.wait(lock, [&] { return sched.ready.empty() && sched.running == 0; });
+
+        sched.stopping = true;
+        sched.work_available.notify_all();
+    }
+
+    for (std::thread& t : workers)
+        t.join();
+}
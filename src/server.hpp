@@ -0,0 +1,27 @@
+#ifndef SERVER_INCL
+#define SERVER_INCL
+
+#include <cstddef>
+
+// Multi-game server: many independent sessions (games) in one process, searched on a shared pool of worker threads.
+// Every line on stdin is "<session id> <command>", every output line starts with the session id:
+//
+//   <id> position [startpos | fen <fen>] [moves ...]   -> (nothing, or "<id> error ..." if invalid)
+//   <id> go [depth <n>] [nodes <n>] [mate <n>]         -> "<id> info ..." and "<id> bestmove <move>"
+//           [movetime <ms>] [infinite]                    (the limits of uci go)
+//   <id> stop                                          -> end the session's search now
+//   <id> ucinewgame                                    -> forget the session's table
+//   <id> close                                         -> end the session
+//   stats                                              -> "stats sessions <n> memory <bytes>"
+//   quit                                               -> finish every queued command, then leave server mode
+//
+// A session is created by it's first command. Commands of a session run in order, one at a time,
+// different sessions run in parallel. Each session owns a small transposition table (tt_entries)
+namespace Server
+{
+
+void run(int threads, size_t tt_entries);
+
+} // namespace Server
+
+#endif // SERVER_INCL
@@ -0,0 +1,109 @@
+#include "stats.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+thread_local Stats::search_stats Stats::current;
+
+static std::mutex          last_mutex;
+static Stats::search_stats last_stats;
+
+void Stats::publish()
+{
+    std::lock_guard<std::mutex> lock{last_mutex};
+    last_stats = current;
+}
+
+Stats::search_stats Stats::last()
+{
+    std::lock_guard<std::mutex> lock{last_mutex};
+    return last_stats;
+}
+
+// plies that were reached
+static int ply_count(const Stats::search_stats& stats)
+{
+    int plies = Stats::MAX_PLY;
+
+    while (plies > 0 && stats.nodes_per_ply[plies - 1] == 0)
+        plies--;
+
+    return plies;
+}
+
+static double percent(uint64_t part, uint64_t total) { return total ? 100.0 * part / total : 0.0; }
+
+void Stats::print(const search_stats& stats)
+{
+    uint64_t nodes = 0;
+
+    for (uint64_t n : stats.nodes_per_ply)
+        nodes += n;
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    std::cout << "nodes " << nodes << " (qnodes " << stats.qnodes << ")\n";
+
+    for (int ply = 0; ply < ply_count(stats); ply++)
+        std::cout << "  ply " << std::setw(2) << ply << ": " << stats.nodes_per_ply[ply] << '\n';
+
+    std::cout << "tt probes " << stats.tt_probes << ", hits " << stats.tt_hits << " ("
+              << percent(stats.tt_hits, stats.tt_probes) << "%), cutoffs " << stats.tt_cutoffs << " ("
+              << percent(stats.tt_cutoffs, stats.tt_probes) << "%)\n";
+
+    std::cout << "leaf evals " << stats.leaf_evals << ", static eval from tt " << stats.tt_eval_hits << '\n';
+    std::cout << "eval cache probes " << stats.eval_cache_probes << ", hits " << stats.eval_cache_hits << " ("
+              << percent(stats.eval_cache_hits, stats.eval_cache_probes) << "%)\n";
+    std::cout << "pawn hash probes " << stats.pawn_hash_probes << ", hits " << stats.pawn_hash_hits << " ("
+              << percent(stats.pawn_hash_hits, stats.pawn_hash_probes) << "%)\n";
+    std::cout << "bitbase hits " << stats.bitbase_hits << '\n';
+
+    std::cout << "beta cutoffs " << stats.beta_cutoffs << ", first move " << stats.first_move_cutoffs << " ("
+              << percent(stats.first_move_cutoffs, stats.beta_cutoffs) << "%)\n";
+
+    std::cout << "  by move index:";
+
+    for (uint64_t n : stats.cutoff_move_index)
+        std::cout << ' ' << n;
+
+    std::cout << "\nre-searches " << stats.re_searches << ", pruned " << stats.pruned << '\n';
+    std::cout << "extensions: check " << stats.check_extensions << ", singular " << stats.singular_extensions << '\n';
+
+    const char* timer_names[TIMER_COUNT] = {"movegen", "eval", "make/unmake"};
+
+    for (int t = 0; t < TIMER_COUNT; t++)
+        std::cout << "time " << timer_names[t] << ": " << stats.time_ns[t] / 1e6 << " ms\n";
+
+    std::cout << std::defaultfloat;
+}
+
+std::string Stats::json(const search_stats& stats)
+{
+    std::ostringstream out;
+
+    out << "{\"nodes_per_ply\":[";
+
+    for (int ply = 0; ply < ply_count(stats); ply++)
+        out << (ply ? "," : "") << stats.nodes_per_ply[ply];
+
+    out << "],\"qnodes\":" << stats.qnodes << ",\"tt_probes\":" << stats.tt_probes << ",\"tt_hits\":" << stats.tt_hits
+        << ",\"tt_cutoffs\":" << stats.tt_cutoffs << ",\"leaf_evals\":" << stats.leaf_evals
+        << ",\"tt_eval_hits\":" << stats.tt_eval_hits << ",\"eval_cache_probes\":" << stats.eval_cache_probes
+        << ",\"eval_cache_hits\":" << stats.eval_cache_hits << ",\"pawn_hash_probes\":" << stats.pawn_hash_probes
+        << ",\"pawn_hash_hits\":" << stats.pawn_hash_hits << ",\"bitbase_hits\":" << stats.bitbase_hits
+        << ",\"beta_cutoffs\":" << stats.beta_cutoffs
+        << ",\"first_move_cutoffs\":" << stats.first_move_cutoffs << ",\"cutoff_move_index\":[";
+
+    for (int i = 0; i < CUTOFF_INDEX_BUCKETS; i++)
+        out << (i ? "," : "") << stats.cutoff_move_index[i];
+
+    out << "],\"re_searches\":" << stats.re_searches << ",\"pruned\":" << stats.pruned
+        << ",\"check_extensions\":" << stats.check_extensions
+        << ",\"singular_extensions\":" << stats.singular_extensions
+        << ",\"time_ns\":{\"movegen\":" << stats.time_ns[MOVEGEN] << ",\"eval\":" << stats.time_ns[EVAL]
+        << ",\"make_unmake\":" << stats.time_ns[MAKE_UNMAKE] << "}}";
+
+    return out.str();
+}
@@ -0,0 +1,107 @@
+#ifndef STATS_INCL
+#define STATS_INCL
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Search statistics: nodes per ply, tt use, cutoffs, time spent in move generation / eval / make+unmake.
+// They cost time in the search, so they're only compiled in with SEARCH_STATS defined ('make STATS=1').
+// Without it the STATS_ macros are empty, and the search is exactly as if they weren't there
+namespace Stats
+{
+
+#ifdef SEARCH_STATS
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+constexpr int MAX_PLY = 64;
+
+// cutoffs by the index of the move that caused them (the last bucket is that index or later)
+constexpr int CUTOFF_INDEX_BUCKETS = 16;
+
+enum TIMER
+{
+    MOVEGEN,
+    EVAL,
+    MAKE_UNMAKE,
+    TIMER_COUNT
+};
+
+struct search_stats
+{
+    uint64_t nodes_per_ply[MAX_PLY] = {}; // the last entry counts that ply and deeper
+    uint64_t qnodes                 = 0;  // quiescence nodes (no quiescence search yet)
+
+    uint64_t tt_probes  = 0;
+    uint64_t tt_hits    = 0; // the position was in the table
+    uint64_t tt_cutoffs = 0; // ... and the node returned without searching
+
+    // leaf evaluations, and where their static eval came from
+    uint64_t leaf_evals        = 0;
+    uint64_t tt_eval_hits      = 0; // static eval stored in the tt
+    uint64_t eval_cache_probes = 0; // Engine::static_eval calls (leaves and interior nodes)
+    uint64_t eval_cache_hits   = 0;
+
+    uint64_t pawn_hash_probes = 0;
+    uint64_t pawn_hash_hits   = 0;
+
+    uint64_t bitbase_hits = 0; // nodes with an exact result from the bitbases (not searched any further)
+
+    uint64_t beta_cutoffs                            = 0;
+    uint64_t first_move_cutoffs                      = 0;
+    uint64_t cutoff_move_index[CUTOFF_INDEX_BUCKETS] = {};
+
+    uint64_t re_searches = 0;
+    uint64_t pruned      = 0; // moves or nodes skipped by pruning
+
+    uint64_t check_extensions    = 0;
+    uint64_t singular_extensions = 0;
+
+    uint64_t time_ns[TIMER_COUNT] = {};
+};
+
+// stats of the search running on this thread
+extern thread_local search_stats current;
+
+// the last search to finish (on any thread) makes it's stats the ones reported
+void         publish();
+search_stats        last();
+
+void        print(const search_stats& stats);
+std::string json(const search_stats& stats);
+
+// adds the time of it's scope to a timer
+class scoped_timer
+{
+  public:
+    explicit scoped_timer(TIMER t) : m_timer(t), m_start(std::chrono::steady_clock::now()) {}
+
+    ~scoped_timer()
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - m_start;
+        current.time_ns[m_timer] += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+  private:
+    TIMER                                 m_timer;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace Stats
+
+#ifdef SEARCH_STATS
+#define STATS_RESET()         (Stats::current = {})
+#define STATS_PUBLISH()       Stats::publish()
+#define STATS_ADD(field, n)   (Stats::current.field += (n))
+#define STATS_TIMER(timer)    Stats::scoped_timer stats_timer_##timer{Stats::timer}
+#else
+#define STATS_RESET()         ((void)0)
+#define STATS_PUBLISH()       ((void)0)
+#define STATS_ADD(field, n)   ((void)0)
+#define STATS_TIMER(timer)    ((void)0)
+#endif
+
+#endif // STATS_INCL
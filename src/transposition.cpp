@@ -1,36 +1,174 @@
 #include "transposition.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
 #include <math.h>
+#include <type_traits>
 
-// must be power of 2 size
-static constexpr size_t tt_size       = (1 << 22);
-static constexpr size_t tt_index_mask = tt_size - 1;
+// unix memory mapping
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
-static tt::entry transposition_table[tt_size];
+// all zero bytes is an invalid entry, so the table can come from calloc: the OS hands us zeroed pages
+// on first touch, instead of us writing ~150mb at startup
+static_assert(static_cast<int>(tt::NODE_TYPE::INVALID) == 0);
+static_assert(std::is_trivially_copyable_v<tt::entry>);
 
-// fill transposition table with invalid entries
-void tt::init()
+// every table file starts with this, the entries follow
+struct table_file_header
 {
-    for (size_t i = 0; i < tt_size; i++)
-        transposition_table[i] = entry{};
+    char     magic[4]      = {'C', 'S', 'T', 'T'};
+    uint32_t version       = 2;
+    uint64_t entry_size    = sizeof(tt::entry);
+    uint64_t entry_count   = 0;
+    uint64_t zobrist_print = Zobrist::fingerprint();
+
+    // keep the entries after the header aligned
+    char padding[32] = {};
+};
+
+static_assert(sizeof(table_file_header) == 64);
+
+tt::table::table(size_t entries) : m_size(entries), m_index_mask(entries - 1)
+{
+    // must be power of 2 size
+    assert(entries > 0 && (entries & (entries - 1)) == 0);
+
+    clear();
 }
 
-void tt::store(tt::entry entry)
+tt::table::~table() { release(); }
+
+void tt::table::release()
 {
-    size_t tt_index = tt_index_mask & entry.full_hash;
+    if (m_mapped_file != nullptr)
+        munmap(m_mapped_file, m_mapped_file_size);
+    else
+        std::free(m_entries);
 
-    // currently using "replace always" scheme, but their are many others worth considering
+    m_mapped_file      = nullptr;
+    m_mapped_file_size = 0;
+    m_entries          = nullptr;
+}
+
+void tt::table::clear()
+{
+    release();
+    m_entries = static_cast<tt::entry*>(std::calloc(m_size, sizeof(tt::entry)));
+
+    if (m_entries == nullptr)
+    {
+        std::cerr << "Failed to allocate transposition table" << std::endl;
+        exit(1);
+    }
+}
+
+void tt::table::store(tt::entry entry)
+{
+    tt::entry& slot = m_entries[m_index_mask & entry.full_hash];
+
+    entry.eval_gen = static_cast<uint8_t>(Engine::eval_generation());
+
+    // leaf entries (depth 0) only save an evaluation, so they never replace an entry with a search below it
+    if (entry.depth == 0 && tt::valid_entry(slot) && slot.depth > 0)
+        return;
+
+    // otherwise using "replace always" scheme, but their are many others worth considering
     // https://www.chessprogramming.org/Transposition_Table#Replacement_Strategies
-    transposition_table[tt_index] = entry;
+    slot = entry;
+}
+
+int tt::table::hashfull() const
+{
+    const size_t sample = std::min<size_t>(m_size, 1000);
+    size_t       used   = 0;
+
+    for (size_t i = 0; i < sample; i++)
+        used += tt::valid_entry(m_entries[i]);
+
+    return static_cast<int>(used * 1000 / sample);
 }
 
-tt::entry tt::lookup(zhash_t pos_hash)
+tt::entry tt::table::lookup(zhash_t pos_hash) const
 {
-    tt::entry result = transposition_table[tt_index_mask & pos_hash];
+    tt::entry result = m_entries[m_index_mask & pos_hash];
 
-    // the index collided, but the full hash didn't.
-    if (pos_hash != result.full_hash)
+    // the index collided, but the full hash didn't. (or the slot is still zeroed)
+    if (pos_hash != result.full_hash || !tt::valid_entry(result))
         return entry{};
 
+    // evaluated with another network (or nnue turned on or off) since
+    if (result.eval_gen != static_cast<uint8_t>(Engine::eval_generation()))
+        result.static_eval = NO_STATIC_EVAL;
+
     return result;
 }
+
+bool tt::table::save(const std::string& path) const
+{
+    std::ofstream file{path, std::ios::binary};
+
+    table_file_header header{};
+    header.entry_count = m_size;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(m_entries), size_bytes());
+
+    return static_cast<bool>(file);
+}
+
+bool tt::table::load(const std::string& path)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd == -1)
+        return false;
+
+    table_file_header expected{};
+    table_file_header header{};
+
+    expected.entry_count = m_size;
+
+    const size_t file_size = sizeof(table_file_header) + size_bytes();
+
+    const bool header_ok = read(fd, &header, sizeof(header)) == sizeof(header)
+                        && std::memcmp(&header, &expected, sizeof(header)) == 0 && lseek(fd, 0, SEEK_END) == off_t(file_size);
+
+    // private: pages the search writes to are copied, the file never changes
+    void* mapping = header_ok ? mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+
+    // the mapping stays valid after closing
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+        return false;
+
+    release();
+
+    m_mapped_file      = mapping;
+    m_mapped_file_size = file_size;
+    m_entries          = reinterpret_cast<tt::entry*>(static_cast<char*>(mapping) + sizeof(table_file_header));
+
+    return true;
+}
+
+tt::table& tt::global()
+{
+    static table engine_table;
+    return engine_table;
+}
+
+void tt::init() { global().clear(); }
+
+bool tt::save(const std::string& path) { return global().save(path); }
+
+bool tt::load(const std::string& path) { return global().load(path); }
+
+void tt::store(tt::entry entry) { global().store(entry); }
+
+tt::entry tt::lookup(zhash_t pos_hash) { return global().lookup(pos_hash); }
@@ -5,35 +5,98 @@
 #include "evaluate.hpp"
 #include "zobrist.hpp"
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
 using Engine::centipawn;
 
 namespace tt
 {
 
-void init();
-
-enum class NODE_TYPE
+enum class NODE_TYPE : uint8_t
 {
-    PV,     // Exact: Principal Variation
-    ALL,    // Upper bound: all moves were searched
-    CUT,    // Lower bound: a cutoff was found
-    INVALID // Invalid: nothing is stored here.
+    INVALID, // Invalid: nothing is stored here. (zero, so zeroed memory is an empty table)
+    PV,      // Exact: Principal Variation
+    ALL,     // Upper bound: all moves were searched
+    CUT      // Lower bound: a cutoff was found
 };
 
+// static_eval of an entry which doesn't know the static eval of it's position
+constexpr centipawn NO_STATIC_EVAL = Engine::NEGATIVE_INF_EVAL;
+
 // entry of a transposition table
 struct entry
 {
-    ChessMove best_move = {};
-    centipawn value     = 0;
-    NODE_TYPE node_type = NODE_TYPE::INVALID;
-    int       depth     = 0;
-    zhash_t   full_hash = 0;
+    ChessMove best_move   = {};
+    centipawn value       = 0;
+    centipawn static_eval = NO_STATIC_EVAL;
+    NODE_TYPE node_type   = NODE_TYPE::INVALID;
+    uint8_t   eval_gen    = 0; // low bits of the eval generation static_eval is from (set by store)
+    int       depth       = 0;
+    zhash_t   full_hash   = 0;
 };
 
 inline bool valid_entry(entry e) { return e.node_type != NODE_TYPE::INVALID; }
 
-void store(entry e);
+// entries in the engine's table (~150mb)
+constexpr size_t DEFAULT_ENTRIES = (1 << 22);
+
+// A transposition table. The engine has one (the functions below use it),
+// and every engine instance (see instance.hpp) owns a smaller one
+class table
+{
+  public:
+    // entries must be a power of 2. The memory is only touched as the search uses it
+    explicit table(size_t entries = DEFAULT_ENTRIES);
+    ~table();
+
+    table(const table&)            = delete;
+    table& operator=(const table&) = delete;
+
+    // forget everything (fresh memory, so this is cheap too)
+    void clear();
+
+    // a looked up entry only keeps its static_eval if the evaluation function didn't change since it was stored
+    void  store(entry e);
+    entry lookup(zhash_t pos_hash) const;
+
+    // write the table to file, so a later run can start with it.
+    bool save(const std::string& path) const;
+
+    // replace the table with one saved to file. The file is memory mapped (privately, so the search never writes to
+    // it), and pages are read as the search touches them, so loading is instant no matter the size.
+    // A file from another version, table size or hashing scheme is rejected, and the current table is kept
+    bool load(const std::string& path);
+
+    size_t entries() const { return m_size; }
+
+    // how full the table is, in permille (uci hashfull), from a sample of entries
+    int hashfull() const;
+
+    size_t size_bytes() const { return m_size * sizeof(entry); }
+
+  private:
+    // give back the memory of the current table, wherever it came from
+    void release();
+
+    entry* m_entries = nullptr;
+    size_t m_size;
+    size_t m_index_mask;
+
+    // when the table was loaded from file, this is the whole mapping (the header, then the table)
+    void*  m_mapped_file      = nullptr;
+    size_t m_mapped_file_size = 0;
+};
+
+// the engine's table
+table& global();
 
+// same as the table functions, on the engine's table
+void  init();
+bool  save(const std::string& path);
+bool  load(const std::string& path);
+void  store(entry e);
 entry lookup(zhash_t pos_hash);
 
 } // namespace tt
@@ -5,7 +5,6 @@
 
 #include <cassert>
 #include <cstdint>
-#include <immintrin.h>
 #include <string>
 
 /* This file contains the definition and functions for the bitboard type,
@@ -84,16 +83,34 @@ inline square pop_lsb(bitboard& b)
     return ret;
 }
 
-// we can use this software implementation of PEXT / PDEP later
-// https://github.com/zwegner/zp7
+// software PEXT / PDEP, so they work on every cpu (and in constant expressions).
+// the slider lookups, where speed matters, use the BMI2 instruction when it's fast (see movegen.cpp)
 
 // returns a bitboard with the lowest bits corresponding to
 // the bits in bb in the positions set in mask
-constexpr bitboard pext(const bitboard bb, const bitboard mask) { return _pext_u64(bb, mask); }
+constexpr bitboard pext(const bitboard bb, bitboard mask)
+{
+    bitboard result = BB_ZERO;
+
+    for (bitboard bit = 1; mask; bit <<= 1, mask &= mask - 1)
+        if (bb & mask & -mask)
+            result |= bit;
+
+    return result;
+}
 
 // returns a bitboard where lowest bits of bb are moved
 // into positions set in mask
-constexpr bitboard pdep(const bitboard bb, const bitboard mask) { return _pdep_u64(bb, mask); }
+constexpr bitboard pdep(const bitboard bb, bitboard mask)
+{
+    bitboard result = BB_ZERO;
+
+    for (bitboard bit = 1; mask; bit <<= 1, mask &= mask - 1)
+        if (bb & bit)
+            result |= mask & -mask;
+
+    return result;
+}
 
 // population count: count of set bits
 constexpr int popcnt(const bitboard bb) { return __builtin_popcountll(bb); }
@@ -48,4 +48,19 @@ zhash_t Zobrist::ep_square(square sq)
 {
     assert(is_valid(sq));
     return hash_value_lookup[HASH_VALUE_LOOKUP_SIZE - file_num(sq)];
-};
\ No newline at end of file
+};
+
+uint64_t Zobrist::fingerprint()
+{
+    // FNV-1a over the key size and every key
+    uint64_t fp = 0xcbf29ce484222325;
+
+    auto mix = [&fp](uint64_t value) { fp = (fp ^ value) * 0x100000001b3; };
+
+    mix(sizeof(zhash_t));
+
+    for (size_t i = 0; i < HASH_VALUE_LOOKUP_SIZE; i++)
+        mix(hash_value_lookup[i]);
+
+    return fp;
+}
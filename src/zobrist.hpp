@@ -22,5 +22,9 @@ zhash_t black_to_move();
 zhash_t castle_right(int cr);
 zhash_t ep_square(square sq);
 
+// identifies the hashing scheme: changes if any key (or the key type) changes.
+// for rejecting saved data (e.g. a transposition table file) made with other keys
+uint64_t fingerprint();
+
 } // namespace Zobrist
 #endif // ZOBRIST_INCL
\ No newline at end of file
@@ -0,0 +1,69 @@
+#!/bin/sh
+set -u
+
+#
+#   This test runs a batch over fens.txt with several threads, and checks the results
+#   come out in the order of the file (each position once), whatever thread finished first.
+#   Then it checks comments are skipped, and a bad line is an error record that doesn't end the batch
+#
+
+if [ -z "${1-}" ]
+then
+    echo "usage: ${0} [engine executable to test]"
+    exit 2
+fi
+
+engine_exe="${1}"
+
+# check executable exists and is executable
+if [ ! -x "${engine_exe}" ]
+then
+    echo "ERROR: can't find or execute engine exe (expected at ${engine_exe})"
+    echo "exiting..."
+    exit 2
+fi
+
+depth=3
+threads=4
+
+expected_tf=$(mktemp /tmp/batch_order_XXXXXXX)
+received_tf=$(mktemp /tmp/batch_order_XXXXXXX)
+epd_tf=$(mktemp /tmp/batch_order_XXXXXXX)
+
+# remove temp files at end of program
+trap 'rm -f -- ${expected_tf} ${received_tf} ${epd_tf}' 0 2 3 15
+
+echo "================= TESTING BATCH ORDER =================="
+
+grep -v '^ *$' fens.txt > "${expected_tf}"
+
+printf 'batch %s %s %s\nquit' "fens.txt" "${depth}" "${threads}" | ${engine_exe} | grep '^{' | sed 's/.*"fen":"\([^"]*\)".*/\1/' > "${received_tf}"
+
+if diff -u --label="EXPECTED" --label="ENGINE" "${expected_tf}" "${received_tf}"
+then
+    echo "***PASSED TEST*** $(wc -l < "${expected_tf}") positions, ${threads} threads"
+else
+    echo "!!!FAILED TEST!!! batch results aren't in input order"
+    exit 1
+fi
+
+printf '# comment\n\n%s\nnot a position\n%s\n' "$(head -n 1 fens.txt)" "$(sed -n 2p fens.txt)" > "${epd_tf}"
+
+engine_output=$(printf 'batch %s %s %s\nquit' "${epd_tf}" "${depth}" "${threads}" | ${engine_exe} | grep '^{' | grep -Po '"line":[0-9]+|"error"|"bestmove"' | tr '\n' ' ')
+
+expected_output='"line":3 "bestmove" "line":4 "error" "line":5 "bestmove" '
+
+if [ "${engine_output}" = "${expected_output}" ]
+then
+    echo "***PASSED TEST*** comments skipped, bad line reported"
+else
+    echo "!!!FAILED TEST!!! comments and bad lines"
+    echo "Expected: ${expected_output}"
+    echo "Received: ${engine_output}"
+    exit 1
+fi
+
+echo "================= ALL TESTS PASSED ===================="
+echo
+
+exit 0
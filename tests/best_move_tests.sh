@@ -33,7 +33,7 @@ while read -r csv_line; do
     fen=$(echo "${csv_line}" | awk -F ',' '{print $1} ')
     best_move=$(echo "${csv_line}" | awk -F ',' '{print $2}' | grep -Po "[a-h][1-8][a-h][1-8]")
 
-    engine_output=$(printf 'position fen %s\ngo depth %s\nquit' "${fen}" "${depth}" | ${engine_exe} | grep -Po "[a-h][1-8][a-h][1-8]")
+    engine_output=$(printf 'position fen %s\ngo depth %s\nquit' "${fen}" "${depth}" | ${engine_exe} | grep "^bestmove" | grep -Po "[a-h][1-8][a-h][1-8]")
 
     if [ "${engine_output}" = "${best_move}" ]
     then
@@ -0,0 +1,70 @@
+#!/bin/sh
+set -u
+
+#
+#   This test checks that the engine knows simple endgames (KPK wins and draws) from the bitbases:
+#   a win or loss has a known win score, a draw scores 0 (all relative to the side to move)
+#
+
+if [ -z "${1-}" ]
+then
+    echo "usage: ${0} [engine executable to test]"
+    exit 2
+fi
+
+engine_exe="${1}"
+
+# check executable exists and is executable
+if [ ! -x "${engine_exe}" ]
+then
+    echo "ERROR: can't find or execute engine exe (expected at ${engine_exe})"
+    echo "exiting..."
+    exit 2
+fi
+
+depth=4
+
+# Engine::KNOWN_WIN_EVAL
+known_win=10000
+
+echo "================= TESTING BITBASES ====================="
+
+while read -r csv_line; do
+
+    fen=$(echo "${csv_line}" | awk -F ',' '{print $1}')
+    result=$(echo "${csv_line}" | awk -F ',' '{print $2}' | tr -d ' ')
+
+    score=$(printf 'position fen %s\ngo depth %s\nquit' "${fen}" "${depth}" | ${engine_exe} | grep "^info depth" | tail -n 1 | grep -Po "score cp -?[0-9]+" | awk '{print $3}')
+
+    engine_output="unknown"
+
+    if [ -n "${score}" ]
+    then
+        if [ "${score}" -ge "${known_win}" ]
+        then
+            engine_output="win"
+        elif [ "${score}" -le "-${known_win}" ]
+        then
+            engine_output="loss"
+        elif [ "${score}" -eq 0 ]
+        then
+            engine_output="draw"
+        fi
+    fi
+
+    if [ "${engine_output}" = "${result}" ]
+    then
+        echo "***PASSED TEST*** FEN: ${fen}"
+    else
+        echo "!!!FAILED TEST!!! FEN: ${fen}"
+        echo "Expected result: ${result}"
+        echo "Received result: ${engine_output} (score ${score})"
+        exit 1;
+    fi
+
+done < bitbase_fens.csv
+
+echo "================= ALL TESTS PASSED ===================="
+echo
+
+exit 0
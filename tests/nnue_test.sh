@@ -0,0 +1,91 @@
+#!/bin/sh
+set -u
+
+#
+#   This test checks the incrementally updated nnue accumulator matches one computed from scratch,
+#   over random make/unmake walks from every position in fens.txt (nnue is turned on halfway through a walk).
+#   Then it checks a network saved with savenet loads back with EvalFile unchanged,
+#   and that a truncated network file is rejected
+#
+
+if [ -z "${1-}" ]
+then
+    echo "usage: ${0} [engine executable to test]"
+    exit 2
+fi
+
+engine_exe="${1}"
+
+# check executable exists and is executable
+if [ ! -x "${engine_exe}" ]
+then
+    echo "ERROR: can't find or execute engine exe (expected at ${engine_exe})"
+    echo "exiting..."
+    exit 2
+fi
+
+plies=40
+
+saved_net_tf=$(mktemp /tmp/nnue_test_XXXXXXX)
+resaved_net_tf=$(mktemp /tmp/nnue_test_XXXXXXX)
+truncated_net_tf=$(mktemp /tmp/nnue_test_XXXXXXX)
+
+# remove temp files at end of program
+trap 'rm -f -- ${saved_net_tf} ${resaved_net_tf} ${truncated_net_tf}' 0 2 3 15
+
+echo "================= TESTING NNUE =================="
+
+grep -v '^ *$' fens.txt | while read -r fen
+do
+    engine_output=$(printf 'position fen %s\nnnuecheck %s\nquit\n' "${fen}" "${plies}" | ${engine_exe} | grep 'nnue accumulator')
+
+    case "${engine_output}" in
+        "nnue accumulator ok"*) echo "***PASSED TEST*** ${fen}" ;;
+        *)
+            echo "!!!FAILED TEST!!! ${fen}"
+            echo "Received: ${engine_output}"
+            exit 1
+            ;;
+    esac
+done || exit 1
+
+# eval with the embedded network, then save it, load it back and save it again
+engine_output=$(printf 'setoption name UseNNUE value true\nprintfen\nprinteval\nsavenet %s\nsetoption name EvalFile value %s\nprinteval\nsavenet %s\nquit\n' \
+    "${saved_net_tf}" "${saved_net_tf}" "${resaved_net_tf}" | ${engine_exe})
+
+evals=$(echo "${engine_output}" | grep '^EVAL:' | uniq | wc -l)
+
+if echo "${engine_output}" | grep -q "couldn't\|failed"
+then
+    echo "!!!FAILED TEST!!! savenet/EvalFile reported an error"
+    echo "${engine_output}"
+    exit 1
+elif ! cmp -s "${saved_net_tf}" "${resaved_net_tf}"
+then
+    echo "!!!FAILED TEST!!! network changed after loading it back"
+    exit 1
+elif [ "${evals}" -ne 1 ]
+then
+    echo "!!!FAILED TEST!!! eval changed after loading the saved network"
+    echo "${engine_output}"
+    exit 1
+else
+    echo "***PASSED TEST*** savenet -> EvalFile round trip"
+fi
+
+head -c 100 "${saved_net_tf}" > "${truncated_net_tf}"
+
+engine_output=$(printf 'setoption name EvalFile value %s\nquit\n' "${truncated_net_tf}" | ${engine_exe})
+
+if echo "${engine_output}" | grep -q "failed to load network"
+then
+    echo "***PASSED TEST*** truncated network rejected"
+else
+    echo "!!!FAILED TEST!!! truncated network wasn't rejected"
+    exit 1
+fi
+
+echo "================= ALL TESTS PASSED ===================="
+echo
+
+exit 0
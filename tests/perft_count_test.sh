@@ -0,0 +1,51 @@
+#!/bin/sh
+set -u
+
+#
+#   This test checks our 'perft' node counts against the published ones
+#   (https://www.chessprogramming.org/Perft_Results), so it doesn't need another engine
+#
+
+if [ -z "${1-}" ]
+then
+    echo "usage: ${0} [engine executable to test]"
+    exit 2
+fi
+
+engine_exe="${1}"
+
+# check executable exists and is executable
+if [ ! -x "${engine_exe}" ]
+then
+    echo "ERROR: can't find or execute engine exe (expected at ${engine_exe})"
+    echo "exiting..."
+    exit 2
+fi
+
+echo "================= TESTING PERFT COUNTS ================="
+
+while read -r csv_line; do
+
+    fen=$(echo "${csv_line}" | awk -F ',' '{print $1}')
+    depth=$(echo "${csv_line}" | awk -F ',' '{print $2}' | tr -d ' ')
+    nodes=$(echo "${csv_line}" | awk -F ',' '{print $3}' | tr -d ' ')
+
+    # the report is a table of "depth | nodes" rows, the nodes with thousands separators
+    engine_output=$(printf 'position fen %s\nperft %s\nquit' "${fen}" "${depth}" | ${engine_exe} | awk -F '|' -v d="${depth}" '$1 ~ /^[0-9]+ *$/ && $1 + 0 == d {gsub(/[ ,]/, "", $2); print $2}')
+
+    if [ "${engine_output}" = "${nodes}" ]
+    then
+        echo "***PASSED TEST*** FEN: ${fen} (depth ${depth})"
+    else
+        echo "!!!FAILED TEST!!! FEN: ${fen} (depth ${depth})"
+        echo "Expected nodes: ${nodes}"
+        echo "Received nodes: ${engine_output}"
+        exit 1;
+    fi
+
+done < perft_counts.csv
+
+echo "================= ALL TESTS PASSED ===================="
+echo
+
+exit 0
@@ -0,0 +1,49 @@
+#!/bin/sh
+set -u
+
+#
+#   This test checks the polyglot keys our book probing uses against the
+#   test vectors of the polyglot book format (moves from the starting position, key)
+#
+
+if [ -z "${1-}" ]
+then
+    echo "usage: ${0} [engine executable to test]"
+    exit 2
+fi
+
+engine_exe="${1}"
+
+# check executable exists and is executable
+if [ ! -x "${engine_exe}" ]
+then
+    echo "ERROR: can't find or execute engine exe (expected at ${engine_exe})"
+    echo "exiting..."
+    exit 2
+fi
+
+echo "================= TESTING POLYGLOT KEYS ================"
+
+while read -r csv_line; do
+
+    moves=$(echo "${csv_line}" | awk -F ',' '{print $1}')
+    key=$(echo "${csv_line}" | awk -F ',' '{print $2}' | tr -d ' ')
+
+    engine_output=$(printf 'position startpos moves %s\nbookprobe\nquit' "${moves}" | ${engine_exe} | grep "^polyglot key" | awk '{print $3}')
+
+    if [ "${engine_output}" = "${key}" ]
+    then
+        echo "***PASSED TEST*** MOVES: ${moves}"
+    else
+        echo "!!!FAILED TEST!!! MOVES: ${moves}"
+        echo "Expected key: ${key}"
+        echo "Received key: ${engine_output}"
+        exit 1;
+    fi
+
+done < polyglot_keys.csv
+
+echo "================= ALL TESTS PASSED ===================="
+echo
+
+exit 0
@@ -18,8 +18,14 @@ fi
 # make sure current directory is PROJECTROOT/tests -- instead of directory script was ran from (tests are stored there)
 cd -P -- "$(dirname -- "${0}")" &&
 ./perft_compare_test.sh "${1}" &&
+./perft_count_test.sh "${1}" &&
 ./fen_serialization_test.sh "${1}" &&
-./best_move_tests.sh "${1}"
+./best_move_tests.sh "${1}" &&
+./bitbase_test.sh "${1}" &&
+./polyglot_key_test.sh "${1}" &&
+./batch_order_test.sh "${1}" &&
+./nnue_test.sh "${1}" &&
+./tt_persist_test.sh "${1}"
 
 exit 0
 
@@ -0,0 +1,56 @@
+#!/bin/sh
+set -u
+
+#
+#   This test saves the transposition table after a search, loads it back into a cleared
+#   table, and saves it again: both files must be the same
+#
+
+if [ -z "${1-}" ]
+then
+    echo "usage: ${0} [engine executable to test]"
+    exit 2
+fi
+
+engine_exe="${1}"
+
+# check executable exists and is executable
+if [ ! -x "${engine_exe}" ]
+then
+    echo "ERROR: can't find or execute engine exe (expected at ${engine_exe})"
+    echo "exiting..."
+    exit 2
+fi
+
+depth=5
+
+saved_tf=$(mktemp /tmp/tt_persist_XXXXXXX)
+resaved_tf=$(mktemp /tmp/tt_persist_XXXXXXX)
+
+# remove temp files at end of program
+trap 'rm -f -- ${saved_tf} ${resaved_tf}' 0 2 3 15
+
+echo "================= TESTING TT SAVE/LOAD ================="
+
+# ucinewgame clears the table, so the second file only has what was loaded
+engine_output=$(printf 'position startpos\ngo depth %s\nsavett %s\nucinewgame\nloadtt %s\nsavett %s\nquit' "${depth}" "${saved_tf}" "${saved_tf}" "${resaved_tf}" | ${engine_exe} | grep "couldn't")
+
+if [ -n "${engine_output}" ]
+then
+    echo "!!!FAILED TEST!!! engine reported:"
+    echo "${engine_output}"
+    exit 1
+fi
+
+if cmp -s "${saved_tf}" "${resaved_tf}"
+then
+    echo "***PASSED TEST*** table saved after depth ${depth} loads back unchanged"
+else
+    echo "!!!FAILED TEST!!! the loaded table isn't the saved one"
+    exit 1
+fi
+
+echo "================= ALL TESTS PASSED ===================="
+echo
+
+exit 0